@@ -0,0 +1,120 @@
+#include "blockflattener.h"
+#include <qmath.h>
+
+BlockFlattener::BlockFlattener(const QMap<QString, GraphicsPrimitive> &iBlockItems)
+    : mBlockItems(iBlockItems)
+{
+}
+
+GraphicsPrimitive BlockFlattener::getFlattenedPrimitive(const GraphicsPrimitive &iItem)
+{
+    if (iItem.items.isEmpty()) {
+        // shares the arrays of iItem:
+        return iItem;
+    }
+    QVector<GraphicsPrimitive> blocks;
+    blocks.reserve(iItem.items.count());
+    int segments = iItem.segments.count();
+    int arcs = iItem.segments.arcCount();
+    for (const GraphicsItem &item: iItem.items) {
+        blocks.append(getFlattenedBlock(item.name));
+        segments += blocks.last().segments.count() * item.columns * item.rows;
+        arcs += blocks.last().segments.arcCount() * item.columns * item.rows;
+    }
+    GraphicsPrimitive primitive;
+    primitive.name = iItem.name;
+    primitive.segments.reserve(segments, arcs);
+    addMappedPrimitive(primitive, iItem, QTransform());
+    for (int i = 0; i < blocks.count(); ++i) {
+        for (const GraphicsItem &item: getArrayItems(iItem.items.at(i))) {
+            addMappedPrimitive(primitive, blocks.at(i), getItemTransform(item));
+        }
+    }
+    return primitive;
+}
+
+GraphicsPrimitive BlockFlattener::getFlattenedBlock(const QString &iName)
+{
+    QHash<QString, GraphicsPrimitive>::const_iterator it = mFlattenedBlocks.constFind(iName);
+    if (it != mFlattenedBlocks.constEnd()) {
+        return it.value();
+    }
+    // a missing block stays out of the memo, so looking it up never writes:
+    if (!mBlockItems.contains(iName)) {
+        return GraphicsPrimitive();
+    }
+    // a block inserting itself finds itself empty instead of recursing endlessly:
+    mFlattenedBlocks.insert(iName, GraphicsPrimitive());
+    GraphicsPrimitive block = getFlattenedPrimitive(mBlockItems.value(iName));
+    mFlattenedBlocks.insert(iName, block);
+    return block;
+}
+
+QTransform BlockFlattener::getItemTransform(const GraphicsItem &iItem)
+{
+    QTransform trans;
+    trans.translate(iItem.pos.x(), iItem.pos.y());
+    trans.rotate(iItem.angle);
+    trans.scale(iItem.sx, iItem.sy);
+    return trans;
+}
+
+QVector<GraphicsItem> BlockFlattener::getArrayItems(const GraphicsItem &iItem)
+{
+    if (iItem.columns <= 1 && iItem.rows <= 1) {
+        return QVector<GraphicsItem>() << iItem;
+    }
+    QVector<GraphicsItem> items;
+    items.reserve(iItem.columns * iItem.rows);
+    QTransform rotation;
+    rotation.rotate(iItem.angle);
+    for (int row = 0; row < iItem.rows; ++row) {
+        for (int column = 0; column < iItem.columns; ++column) {
+            GraphicsItem item = iItem;
+            item.pos += rotation.map(QPointF(column * iItem.columnSpacing, row * iItem.rowSpacing));
+            item.columns = 1;
+            item.rows = 1;
+            items.append(item);
+        }
+    }
+    return items;
+}
+
+void BlockFlattener::addMappedSegments(GraphicsPrimitive &ioPrimitive, const GraphicsSegments &iSegments,
+                                       const QTransform &iTrans)
+{
+    if (iTrans.isIdentity()) {
+        ioPrimitive.segments.append(iSegments);
+        return;
+    }
+    qreal det = iTrans.determinant();
+    qreal row1 = iTrans.m11() * iTrans.m11() + iTrans.m12() * iTrans.m12();
+    qreal row2 = iTrans.m21() * iTrans.m21() + iTrans.m22() * iTrans.m22();
+    qreal dot = iTrans.m11() * iTrans.m21() + iTrans.m12() * iTrans.m22();
+    bool isSimilar = qAbs(row1 - row2) <= 1e-9 * (row1 + row2) && qAbs(dot) <= 1e-9 * (row1 + row2);
+    for (const GraphicsSegment &segment: iSegments) {
+        if (segment.type == GraphicsSegment::LineSegment) {
+            ioPrimitive.segments.addLine(iTrans.map(segment.start), iTrans.map(segment.end));
+        } else if (isSimilar) {
+            QPointF start = iTrans.map(segment.start);
+            // mirroring reverses the direction:
+            ioPrimitive.segments.addArc(iTrans.map(segment.center), segment.radius * qSqrt(qAbs(det)), start,
+                                        segment.start == segment.end ? start : iTrans.map(segment.end),
+                                        segment.clockwise != (det < 0));
+        } else {
+            QPainterPath path;
+            segment.appendTo(path);
+            ioPrimitive.path.addPath(iTrans.map(path));
+        }
+    }
+}
+
+void BlockFlattener::addMappedPrimitive(GraphicsPrimitive &ioPrimitive, const GraphicsPrimitive &iPrimitive,
+                                        const QTransform &iTrans)
+{
+    addMappedSegments(ioPrimitive, iPrimitive.segments, iTrans);
+    ioPrimitive.path.addPath(iTrans.map(iPrimitive.path));
+    for (const QPainterPath &region: iPrimitive.regions) {
+        ioPrimitive.regions.append(iTrans.map(region));
+    }
+}
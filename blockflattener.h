@@ -0,0 +1,39 @@
+#ifndef BLOCKFLATTENER_H
+#define BLOCKFLATTENER_H
+
+#include <QHash>
+#include <QMap>
+#include <QTransform>
+#include "dxfcreationadapter.h"
+
+/*! Expands the inserts of a layer into plain geometry. Every block is flattened once,
+ *  bottom-up, and kept, so each insert only maps the flattened block by its transform. */
+class BlockFlattener
+{
+public:
+    explicit BlockFlattener(const QMap<QString, GraphicsPrimitive> &iBlockItems = QMap<QString, GraphicsPrimitive>());
+
+    /*! @return The geometry of iItem and of all blocks it inserts. */
+    GraphicsPrimitive getFlattenedPrimitive(const GraphicsPrimitive &iItem);
+    /*! @return The block iName with all blocks it inserts, flattened on first use. Empty
+     *  if there is no such block, without touching the memo. */
+    GraphicsPrimitive getFlattenedBlock(const QString &iName);
+
+    /*! @return The transform of iItem, of its first element if it is an array. */
+    static QTransform getItemTransform(const GraphicsItem &iItem);
+    /*! @return The elements of the array iItem as single inserts, iItem itself if it is none. */
+    static QVector<GraphicsItem> getArrayItems(const GraphicsItem &iItem);
+    /*! Adds iSegments mapped by iTrans to ioPrimitive. Arcs stay arcs under moves, rotations,
+     *  uniform scaling and mirroring, other transforms turn them into curves of the path. */
+    static void addMappedSegments(GraphicsPrimitive &ioPrimitive, const GraphicsSegments &iSegments,
+                                  const QTransform &iTrans);
+    /*! Adds the geometry of iPrimitive, without the blocks it inserts, mapped by iTrans to ioPrimitive. */
+    static void addMappedPrimitive(GraphicsPrimitive &ioPrimitive, const GraphicsPrimitive &iPrimitive,
+                                   const QTransform &iTrans);
+
+private:
+    QMap<QString, GraphicsPrimitive> mBlockItems;
+    QHash<QString, GraphicsPrimitive> mFlattenedBlocks;
+};
+
+#endif // BLOCKFLATTENER_H
@@ -0,0 +1,26 @@
+# Everything but main.cpp, shared with the tests.
+INCLUDEPATH += $$PWD
+
+include($$PWD/thirdparty/dxflib/dxflib.pri)
+
+SOURCES += \
+    $$PWD/beziercurve2arcs/beziercurvetoarcs.cpp \
+    $$PWD/beziercurve2arcs/cubicbeziertools.cpp \
+    $$PWD/beziercurve2arcs/mathtools.cpp \
+    $$PWD/blockflattener.cpp \
+    $$PWD/dxfcreationadapter.cpp \
+    $$PWD/dxfgeometrycache.cpp \
+    $$PWD/gerberconverter.cpp \
+    $$PWD/painterpath2gerber.cpp \
+    $$PWD/pdmalgorithmutil.cpp
+
+HEADERS += \
+    $$PWD/beziercurve2arcs/beziercurvetoarcs.h \
+    $$PWD/beziercurve2arcs/cubicbeziertools.h \
+    $$PWD/beziercurve2arcs/mathtools.h \
+    $$PWD/blockflattener.h \
+    $$PWD/dxfcreationadapter.h \
+    $$PWD/dxfgeometrycache.h \
+    $$PWD/gerberconverter.h \
+    $$PWD/painterpath2gerber.h \
+    $$PWD/pdmalgorithmutil.h
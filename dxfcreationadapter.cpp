@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <QDebug>
 #include <QLineF>
+#include <qmath.h>
 #include <QTransform>
 #include <QPainter>
 #include <QLabel>
@@ -10,31 +11,318 @@
 #include "pdmalgorithmutil.h"
 #include "beziercurve2arcs/beziercurvetoarcs.h"
 
+static void connectTo(QPainterPath &ioPath, const QPointF &iPos)
+{
+    if (ioPath.elementCount() == 0) {
+        ioPath.moveTo(iPos);
+    } else if (QLineF(ioPath.currentPosition(), iPos).length() > 1e-6) {
+        ioPath.lineTo(iPos);
+    }
+}
+
+/*! Appends an arc around iCenter from the (counterclockwise) angle iStartAngle,
+ *  all angles in radians, negative sweeps run clockwise. */
+static void appendArc(QPainterPath &ioPath, const QPointF &iCenter, qreal iRadius,
+                      qreal iStartAngle, qreal iSweep)
+{
+    connectTo(ioPath, iCenter + QPointF(cos(iStartAngle), sin(iStartAngle)) * iRadius);
+    // QPainterPath angles run the other way round because of its downward y axis:
+    ioPath.arcTo(QRectF(iCenter.x() - iRadius, iCenter.y() - iRadius, 2 * iRadius, 2 * iRadius),
+                 -iStartAngle * 180 / M_PI, -iSweep * 180 / M_PI);
+}
+
+/*! Center of the polyline arc from iStartPos to iEndPos, iBulge must not be 0. */
+static QPointF getBulgeCenter(const QPointF &iStartPos, const QPointF &iEndPos, qreal iBulge)
+{
+    QPointF chord = iEndPos - iStartPos;
+    qreal length = QLineF(iStartPos, iEndPos).length();
+    qreal sweep = 4 * atan(iBulge);
+    // the center is left of the chord for counterclockwise arcs:
+    QPointF normal(-chord.y() / length, chord.x() / length);
+    return (iStartPos + iEndPos) / 2 + normal * (length / 2 / tan(sweep / 2));
+}
+
+/*! Appends the polyline segment from iStartPos to iEndPos, an arc if iBulge is not 0. */
+static void appendBulgeSegment(QPainterPath &ioPath, const QPointF &iStartPos, const QPointF &iEndPos, qreal iBulge)
+{
+    if (iBulge == 0 || QLineF(iStartPos, iEndPos).length() == 0) {
+        connectTo(ioPath, iStartPos);
+        ioPath.lineTo(iEndPos);
+        return;
+    }
+    qreal sweep = 4 * atan(iBulge);
+    QPointF center = getBulgeCenter(iStartPos, iEndPos, iBulge);
+    qreal radius = QLineF(center, iStartPos).length();
+    qreal startAngle = atan2(iStartPos.y() - center.y(), iStartPos.x() - center.x());
+    appendArc(ioPath, center, radius, startAngle, sweep);
+}
+
+/*! @return Sweep from iStartAngle to iEndAngle in (0, 2pi], negative for clockwise. */
+static qreal getSweep(qreal iStartAngle, qreal iEndAngle, bool iCcw)
+{
+    qreal sweep = iCcw ? iEndAngle - iStartAngle : iStartAngle - iEndAngle;
+    sweep = fmod(sweep, 2 * M_PI);
+    if (sweep <= 0) {
+        sweep += 2 * M_PI;
+    }
+    return iCcw ? sweep : -sweep;
+}
+
+/*! Point of a (rational) B-spline at the parameter iT, de Boor's algorithm. */
+static QPointF getSplinePos(int iDegree, const DL_Span<double> &iKnots, const DL_Span<DL_HatchVertexData> &iControlPoints,
+                            const DL_Span<double> &iWeights, qreal iT)
+{
+    int count = int(iControlPoints.size);
+    int k = iDegree;
+    while (k < count - 1 && iT >= iKnots[k + 1]) {
+        ++k;
+    }
+    QVector<QPointF> points(iDegree + 1);
+    QVector<qreal> weights(iDegree + 1);
+    for (int j = 0; j <= iDegree; ++j) {
+        int i = k - iDegree + j;
+        weights[j] = int(iWeights.size) == count ? iWeights[i] : 1.0;
+        points[j] = QPointF(iControlPoints[i].x, iControlPoints[i].y) * weights[j];
+    }
+    for (int r = 1; r <= iDegree; ++r) {
+        for (int j = iDegree; j >= r; --j) {
+            int i = k - iDegree + j;
+            qreal span = iKnots[i + iDegree - r + 1] - iKnots[i];
+            qreal alpha = span == 0 ? 0 : (iT - iKnots[i]) / span;
+            points[j] = points[j - 1] * (1 - alpha) + points[j] * alpha;
+            weights[j] = weights[j - 1] * (1 - alpha) + weights[j] * alpha;
+        }
+    }
+    return weights[iDegree] == 0 ? points[iDegree] : points[iDegree] / weights[iDegree];
+}
+
+void GraphicsSegment::appendTo(QPainterPath &ioPath) const
+{
+    if (ioPath.elementCount() == 0 || QLineF(ioPath.currentPosition(), start).length() > 1e-6) {
+        ioPath.moveTo(start);
+    }
+    if (type == LineSegment) {
+        ioPath.lineTo(end);
+        return;
+    }
+    qreal startAngle = atan2(start.y() - center.y(), start.x() - center.x());
+    qreal endAngle = atan2(end.y() - center.y(), end.x() - center.x());
+    if (start == end) {
+        endAngle = startAngle;
+    }
+    appendArc(ioPath, center, radius, startAngle, getSweep(startAngle, endAngle, !clockwise));
+}
+
+GraphicsSegment GraphicsSegments::const_iterator::operator*() const
+{
+    GraphicsSegment segment;
+    segment.start = mSegments->mPoints[2 * mIndex];
+    segment.end = mSegments->mPoints[2 * mIndex + 1];
+    quint8 kind = mSegments->mKinds[mIndex];
+    if (kind != LineKind) {
+        segment.type = GraphicsSegment::ArcSegment;
+        segment.center = mSegments->mCenters[mArc];
+        segment.radius = mSegments->mRadii[mArc];
+        segment.clockwise = kind == ClockwiseArcKind;
+    }
+    return segment;
+}
+
+GraphicsSegments::const_iterator &GraphicsSegments::const_iterator::operator++()
+{
+    if (mSegments->mKinds[mIndex] != LineKind) {
+        ++mArc;
+    }
+    ++mIndex;
+    return *this;
+}
+
+void GraphicsSegments::reserve(int iSegments, int iArcs)
+{
+    mKinds.reserve(iSegments);
+    mPoints.reserve(2 * iSegments);
+    mCenters.reserve(iArcs);
+    mRadii.reserve(iArcs);
+}
+
+void GraphicsSegments::addLine(const QPointF &iStart, const QPointF &iEnd)
+{
+    mKinds.append(LineKind);
+    mPoints.append(iStart);
+    mPoints.append(iEnd);
+}
+
+void GraphicsSegments::addArc(const QPointF &iCenter, qreal iRadius, const QPointF &iStart, const QPointF &iEnd,
+                              bool iClockwise)
+{
+    mKinds.append(iClockwise ? ClockwiseArcKind : ArcKind);
+    mPoints.append(iStart);
+    mPoints.append(iEnd);
+    mCenters.append(iCenter);
+    mRadii.append(iRadius);
+}
+
+void GraphicsSegments::append(const GraphicsSegments &iSegments)
+{
+    if (isEmpty() && mKinds.capacity() == 0 && mCenters.capacity() == 0) {
+        // shares the arrays, unless they were reserved for more:
+        *this = iSegments;
+        return;
+    }
+    mKinds += iSegments.mKinds;
+    mPoints += iSegments.mPoints;
+    mCenters += iSegments.mCenters;
+    mRadii += iSegments.mRadii;
+}
+
+void GraphicsSegments::clear()
+{
+    mKinds.clear();
+    mPoints.clear();
+    mCenters.clear();
+    mRadii.clear();
+}
+
+GraphicsSegments::const_iterator GraphicsSegments::begin() const
+{
+    const_iterator it;
+    it.mSegments = this;
+    return it;
+}
+
+GraphicsSegments::const_iterator GraphicsSegments::end() const
+{
+    const_iterator it;
+    it.mSegments = this;
+    it.mIndex = count();
+    it.mArc = arcCount();
+    return it;
+}
+
+/*! @return The ID of the primitive iName, added to ioPrimitives if it is new. */
+static int getPrimitiveId(const QString &iName, QHash<QString, int> &ioIds, QVector<GraphicsPrimitive> &ioPrimitives)
+{
+    QHash<QString, int>::const_iterator it = ioIds.constFind(iName);
+    if (it != ioIds.constEnd()) {
+        return it.value();
+    }
+    GraphicsPrimitive primitive;
+    primitive.name = iName;
+    ioPrimitives.append(primitive);
+    ioIds.insert(iName, ioPrimitives.count() - 1);
+    return ioPrimitives.count() - 1;
+}
+
+/*! @return iPrimitives by name, sharing their data with iPrimitives. */
+static QMap<QString, GraphicsPrimitive> getPrimitiveMap(const QVector<GraphicsPrimitive> &iPrimitives)
+{
+    QMap<QString, GraphicsPrimitive> primitives;
+    for (const GraphicsPrimitive &primitive: iPrimitives) {
+        primitives.insert(primitive.name, primitive);
+    }
+    return primitives;
+}
+
 DxfCreationAdapter::DxfCreationAdapter()
 {
 }
 
 QMap<QString, GraphicsPrimitive> DxfCreationAdapter::getAllLayers()
 {
-    return mLayers;
+    return getPrimitiveMap(mLayers);
 }
 
 QMap<QString, GraphicsPrimitive> DxfCreationAdapter::getAllBlock()
 {
-    return mBlockItems;
+    return getPrimitiveMap(mBlockItems);
+}
+
+QMap<QString, GraphicsPrimitive> DxfCreationAdapter::takeAllLayers()
+{
+    // clearing leaves the map the only owner of the shared data:
+    QMap<QString, GraphicsPrimitive> layers = getPrimitiveMap(mLayers);
+    mLayers.clear();
+    mLayerIds.clear();
+    // the IDs are gone, the next attributes look their layer up again:
+    mIsCurrentLayerValid = false;
+    mCurrentLayer = -1;
+    return layers;
+}
+
+QMap<QString, GraphicsPrimitive> DxfCreationAdapter::takeAllBlocks()
+{
+    QMap<QString, GraphicsPrimitive> blocks = getPrimitiveMap(mBlockItems);
+    mBlockItems.clear();
+    mBlockIds.clear();
+    mCurrentBlock = -1;
+    return blocks;
 }
 
 GraphicsPrimitive DxfCreationAdapter::getBlock(const QString &iName)
 {
-    return mBlockItems.value(iName);
+    int id = mBlockIds.value(iName, -1);
+    return id < 0 ? GraphicsPrimitive() : mBlockItems.at(id);
+}
+
+void DxfCreationAdapter::setLayerFilter(const QStringList &iLayers)
+{
+    mLayerFilter.clear();
+    for (const QString &layer: iLayers) {
+        mLayerFilter.insert(layer);
+    }
+    mIsCurrentLayerValid = false;
+    mCurrentLayer = -1;
+}
+
+QStringList DxfCreationAdapter::getLayerFilter() const
+{
+    return mLayerFilter.values();
+}
+
+bool DxfCreationAdapter::isLayerSkipped()
+{
+    return mCurrentBlock < 0 && mCurrentLayer < 0;
+}
+
+/*! Resolves mCurrentLayer from the layer of the current attributes. */
+void DxfCreationAdapter::updateCurrentLayer()
+{
+    mCurrentLayerName = attributes.getLayer();
+    QString name = QString::fromUtf8(mCurrentLayerName.c_str());
+    if (!mLayerFilter.isEmpty() && !mLayerFilter.contains(name)) {
+        mCurrentLayer = -1;
+    } else {
+        mCurrentLayer = getPrimitiveId(name, mLayerIds, mLayers);
+    }
+    mIsCurrentLayerValid = true;
+}
+
+GraphicsPrimitive &DxfCreationAdapter::getCurrentPrimitive()
+{
+    return mCurrentBlock < 0 ? mLayers[mCurrentLayer] : mBlockItems[mCurrentBlock];
+}
+
+GraphicsPrimitive &DxfCreationAdapter::getPolylinePrimitive()
+{
+    return mPolyBlock < 0 ? mLayers[mPolyLayer] : mBlockItems[mPolyBlock];
+}
+
+void DxfCreationAdapter::setAttributes(const DL_Attributes &iAttributes)
+{
+    DL_CreationAdapter::setAttributes(iAttributes);
+    // entities mostly come in runs on the same layer:
+    if (!mIsCurrentLayerValid || attributes.getLayer() != mCurrentLayerName) {
+        updateCurrentLayer();
+    }
 }
 
 void DxfCreationAdapter::addLayer(const DL_LayerData &iData)
 {
     QString name = iData.name.c_str();
-    GraphicsPrimitive primitive;
-    primitive.name = name;
-    mLayers[name] = primitive;
+    if (!mLayerFilter.isEmpty() && !mLayerFilter.contains(name)) {
+        return;
+    }
+    getPrimitiveId(name, mLayerIds, mLayers);
 }
 
 void DxfCreationAdapter::addPoint(const DL_PointData &iData)
@@ -44,23 +332,37 @@ void DxfCreationAdapter::addPoint(const DL_PointData &iData)
 
 void DxfCreationAdapter::addLine(const DL_LineData &iData)
 {
-    addPrimitiveLine(attributes.getLayer().c_str(), iData.x1, iData.y1, iData.x2, iData.y2);
+    if (isLayerSkipped()) {
+        return;
+    }
+    addPrimitiveLine(iData.x1, iData.y1, iData.x2, iData.y2);
 }
 
 void DxfCreationAdapter::addArc(const DL_ArcData &iData)
 {
+    if (isLayerSkipped()) {
+        return;
+    }
     QPointF startPos = PdmAlgorithmUtil::getPosByCircleAngle(iData.cx, iData.cy, iData.radius, iData.angle1);
-    QPointF endPos = PdmAlgorithmUtil::getPosByCircleAngle(iData.cx, iData.cy, iData.radius, iData.angle2);
-    addPrimitiveArc(attributes.getLayer().c_str(), QPointF(iData.cx, iData.cy), startPos, endPos);
+    // equal angles make a full circle, exactly:
+    QPointF endPos = qFuzzyCompare(fmod(iData.angle2 - iData.angle1, 360) + 1, 1) ?
+                startPos : PdmAlgorithmUtil::getPosByCircleAngle(iData.cx, iData.cy, iData.radius, iData.angle2);
+    addPrimitiveArc(QPointF(iData.cx, iData.cy), startPos, endPos);
 }
 
 void DxfCreationAdapter::addCircle(const DL_CircleData &iData)
 {
-    addPrimitiveArc(attributes.getLayer().c_str(), iData.cx, iData.cy, iData.radius, 0, 0);
+    if (isLayerSkipped()) {
+        return;
+    }
+    addPrimitiveArc(iData.cx, iData.cy, iData.radius, 0, 0);
 }
 
 void DxfCreationAdapter::addEllipse(const DL_EllipseData &iData)
 {
+    if (isLayerSkipped()) {
+        return;
+    }
     QPointF cPoint(iData.cx, iData.cy);
     QPointF sPoint = cPoint + QPointF(iData.mx, iData.my);
     QLineF sLine(cPoint, sPoint);
@@ -80,7 +382,7 @@ void DxfCreationAdapter::addEllipse(const DL_EllipseData &iData)
     trans.rotate(alpha);
     path = trans.map(path);
 
-    GraphicsPrimitive &primitive = getGraphicsPrimitive(attributes.getLayer().c_str());
+    GraphicsPrimitive &primitive = getCurrentPrimitive();
     QPointF lastPos;
     for (int i = 0; i < path.elementCount(); ++i) {
         QPainterPath::Element element = path.elementAt(i);
@@ -101,6 +403,13 @@ void DxfCreationAdapter::addEllipse(const DL_EllipseData &iData)
 void DxfCreationAdapter::addPolyline(const DL_PolylineData &iData)
 {
     Q_UNUSED(iData);
+    mIsSkippedPoly = isLayerSkipped();
+    if (mIsSkippedPoly) {
+        return;
+    }
+    // vertices carry their own attributes, they stay on the layer of the polyline:
+    mPolyLayer = mCurrentLayer;
+    mPolyBlock = mCurrentBlock;
     mIsFirstVertex = true;
     mCurrentMode = Polyline;
     mIsClosePoly = iData.flags == 1;
@@ -108,11 +417,12 @@ void DxfCreationAdapter::addPolyline(const DL_PolylineData &iData)
 
 void DxfCreationAdapter::addVertex(const DL_VertexData &iData)
 {
+    if (mIsSkippedPoly) {
+        return;
+    }
     if (mIsFirstVertex) {
         mIsFirstVertex = false;
         mFirstVertex = iData;
-        GraphicsPrimitive &primitive = getGraphicsPrimitive(attributes.getLayer().c_str());
-        primitive.path.moveTo(iData.x, iData.y);
     } else {
         QPointF startPos(mLastVertex.x, mLastVertex.y);
         QPointF endPos(iData.x, iData.y);
@@ -122,21 +432,38 @@ void DxfCreationAdapter::addVertex(const DL_VertexData &iData)
     mLastVertex = iData;
 }
 
-void DxfCreationAdapter::addBlock(const DL_BlockData &iData)
+void DxfCreationAdapter::addVertices(const DL_VertexData *iData, int iCount)
 {
-    mBlockName = iData.name.c_str();
-    if (mBlockName == "1") {
-        int i=0;
-        ++i;
+    if (mIsSkippedPoly || iCount <= 0) {
+        return;
     }
+    int i = 0;
+    if (mIsFirstVertex) {
+        mIsFirstVertex = false;
+        mFirstVertex = iData[0];
+        mLastVertex = iData[0];
+        i = 1;
+    }
+    for (; i < iCount; ++i) {
+        QPointF startPos(mLastVertex.x, mLastVertex.y);
+        QPointF endPos(iData[i].x, iData[i].y);
+        addPrimitivePolyline(startPos, endPos, mLastVertex.bulge);
+        mLastVertex = iData[i];
+    }
+}
+
+void DxfCreationAdapter::addBlock(const DL_BlockData &iData)
+{
+    QString name = iData.name.c_str();
+    mCurrentBlock = getPrimitiveId(name, mBlockIds, mBlockItems);
     GraphicsPrimitive primitive;
-    primitive.name = mBlockName;
-    mBlockItems[mBlockName] = primitive;
+    primitive.name = name;
+    mBlockItems[mCurrentBlock] = primitive;
 }
 
 void DxfCreationAdapter::endBlock()
 {
-    mBlockName.clear();
+    mCurrentBlock = -1;
 }
 
 void DxfCreationAdapter::endSection()
@@ -145,6 +472,10 @@ void DxfCreationAdapter::endSection()
 
 void DxfCreationAdapter::endEntity()
 {
+    if (mIsSkippedPoly) {
+        mIsSkippedPoly = false;
+        return;
+    }
     if (mCurrentMode == Polyline && mIsClosePoly) {
         QPointF startPos(mLastVertex.x, mLastVertex.y);
         QPointF endPos(mFirstVertex.x, mFirstVertex.y);
@@ -156,16 +487,135 @@ void DxfCreationAdapter::endEntity()
 
 void DxfCreationAdapter::addInsert(const DL_InsertData &iData)
 {
-    GraphicsPrimitive &primitive = getGraphicsPrimitive(attributes.getLayer().c_str());
+    if (isLayerSkipped()) {
+        return;
+    }
+    GraphicsPrimitive &primitive = getCurrentPrimitive();
     GraphicsItem item;
     item.name = iData.name.c_str();
     item.angle = iData.angle;
     item.pos = QPointF(iData.ipx, iData.ipy);
     item.sx = iData.sx;
     item.sy = iData.sy;
+    item.columns = qMax(1, iData.cols);
+    item.rows = qMax(1, iData.rows);
+    item.columnSpacing = iData.colSp;
+    item.rowSpacing = iData.rowSp;
     primitive.items.append(item);
 }
 
+void DxfCreationAdapter::addHatch(const DL_HatchData &iData)
+{
+    // pattern hatches are not filled on the board:
+    mIsSolidHatch = iData.solid && !isLayerSkipped();
+}
+
+void DxfCreationAdapter::addHatchBoundary(const DL_HatchBoundary &iBoundary)
+{
+    if (!mIsSolidHatch) {
+        return;
+    }
+    QPainterPath region;
+    region.setFillRule(Qt::OddEvenFill);
+    for (size_t i = 0; i < iBoundary.getLoopCount(); ++i) {
+        QPainterPath loop = getHatchLoopPath(iBoundary, i);
+        if (!loop.isEmpty()) {
+            loop.closeSubpath();
+            region.addPath(loop);
+        }
+    }
+    if (!region.isEmpty()) {
+        getCurrentPrimitive().regions.append(region);
+    }
+}
+
+QPainterPath DxfCreationAdapter::getHatchLoopPath(const DL_HatchBoundary &iBoundary, size_t iLoop)
+{
+    QPainterPath path;
+    for (const DL_HatchBoundary::Edge &edge: iBoundary.getEdges(iLoop)) {
+        const DL_HatchEdgeData &data = edge.data;
+        switch (data.type) {
+        case 0: {
+            // polyline, closed by its last vertex:
+            DL_Span<DL_HatchVertexData> vertices = iBoundary.getVertices(edge);
+            for (size_t i = 0; i < vertices.size; ++i) {
+                const DL_HatchVertexData &start = vertices[i];
+                const DL_HatchVertexData &end = vertices[(i + 1) % vertices.size];
+                appendBulgeSegment(path, QPointF(start.x, start.y), QPointF(end.x, end.y),
+                                   edge.hasBulges ? start.bulge : 0);
+            }
+            break;
+        }
+        case 1:
+            connectTo(path, QPointF(data.x1, data.y1));
+            path.lineTo(data.x2, data.y2);
+            break;
+        case 2: {
+            // clockwise arcs store their angles mirrored:
+            qreal startAngle = data.ccw ? data.angle1 : -data.angle1;
+            qreal endAngle = data.ccw ? data.angle2 : -data.angle2;
+            appendArc(path, QPointF(data.cx, data.cy), data.radius, startAngle,
+                      getSweep(startAngle, endAngle, data.ccw));
+            break;
+        }
+        case 3: {
+            qreal startAngle = data.ccw ? data.angle1 : -data.angle1;
+            qreal endAngle = data.ccw ? data.angle2 : -data.angle2;
+            qreal sweep = getSweep(startAngle, endAngle, data.ccw);
+            QPointF center(data.cx, data.cy);
+            QPointF major(data.mx, data.my);
+            QPointF minor(-data.my * data.ratio, data.mx * data.ratio);
+            int count = qMax(8, int(ceil(qAbs(sweep) / (2 * M_PI) * 64)));
+            for (int i = 0; i <= count; ++i) {
+                qreal t = startAngle + sweep * i / count;
+                QPointF pos = center + major * cos(t) + minor * sin(t);
+                if (i == 0) {
+                    connectTo(path, pos);
+                } else {
+                    path.lineTo(pos);
+                }
+            }
+            break;
+        }
+        case 4: {
+            DL_Span<double> knots = iBoundary.getKnots(edge);
+            DL_Span<DL_HatchVertexData> controlPoints = iBoundary.getControlPoints(edge);
+            DL_Span<DL_HatchVertexData> fitPoints = iBoundary.getFitPoints(edge);
+            int degree = int(data.degree);
+            if (degree > 0 && controlPoints.size > size_t(degree)
+                    && knots.size == controlPoints.size + degree + 1) {
+                qreal t0 = knots[degree];
+                qreal t1 = knots[controlPoints.size];
+                int count = int(controlPoints.size) * 8;
+                for (int i = 0; i <= count; ++i) {
+                    QPointF pos = getSplinePos(degree, knots, controlPoints, iBoundary.getWeights(edge),
+                                               t0 + (t1 - t0) * i / count);
+                    if (i == 0) {
+                        connectTo(path, pos);
+                    } else {
+                        path.lineTo(pos);
+                    }
+                }
+            } else {
+                // no usable knot vector, follow the fit points or the control polygon:
+                DL_Span<DL_HatchVertexData> points = fitPoints.empty() ? controlPoints : fitPoints;
+                for (size_t i = 0; i < points.size; ++i) {
+                    if (i == 0) {
+                        connectTo(path, QPointF(points[i].x, points[i].y));
+                    } else {
+                        path.lineTo(points[i].x, points[i].y);
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return path;
+}
+
 void DxfCreationAdapter::printAttributes()
 {
     printf("  Attributes: Layer: %s, ", attributes.getLayer().c_str());
@@ -192,87 +642,46 @@ void DxfCreationAdapter::printAttributes()
 
 GraphicsPrimitive &DxfCreationAdapter::getGraphicsPrimitive(const QString &iPrimitiveName)
 {
-    if (mBlockName.isEmpty()) {
-        return mLayers[iPrimitiveName];
+    if (mCurrentBlock < 0) {
+        return mLayers[getPrimitiveId(iPrimitiveName, mLayerIds, mLayers)];
     } else {
-        return mBlockItems[mBlockName];
+        return mBlockItems[mCurrentBlock];
     }
 }
 
-void DxfCreationAdapter::addPrimitiveLine(const QString &iPrimitiveName, qreal iX1, qreal iY1, qreal iX2, qreal iY2)
+void DxfCreationAdapter::addPrimitiveLine(qreal iX1, qreal iY1, qreal iX2, qreal iY2)
 {
-    GraphicsPrimitive &primitive = getGraphicsPrimitive(iPrimitiveName);
-    primitive.path.moveTo(iX1, iY1);
-    primitive.path.lineTo(iX2, iY2);
+    GraphicsPrimitive &primitive = getCurrentPrimitive();
+    primitive.segments.addLine(QPointF(iX1, iY1), QPointF(iX2, iY2));
 }
 
-void DxfCreationAdapter::addPrimitiveArc(const QString &iPrimitiveName, qreal iCx, qreal iCy, qreal iRadius,
+/*! Angles in degrees, measured clockwise like QLineF::angle() of the (y up) DXF
+ *  coordinates. G03 arcs run counterclockwise in DXF coordinates, G02 arcs clockwise. */
+void DxfCreationAdapter::addPrimitiveArc(qreal iCx, qreal iCy, qreal iRadius,
                                          qreal iStartAngle, qreal iEndAngle, const QString &iType)
 {
-    GraphicsPrimitive &primitive = getGraphicsPrimitive(iPrimitiveName);
-    if (iEndAngle < iStartAngle) {
-        iEndAngle += 360;
-    }
-    qreal arcLength = iEndAngle - iStartAngle;
-    if (iType == "G03") {
-        arcLength -= 360;
-    }
-    primitive.path.moveTo(PdmAlgorithmUtil::getPosByCircleAngle(iCx, iCy, iRadius, iStartAngle, true));
-    primitive.path.arcTo(QRectF(iCx-iRadius,iCy-iRadius,2*iRadius,2*iRadius), iStartAngle, arcLength);
+    QPointF startPos = PdmAlgorithmUtil::getPosByCircleAngle(iCx, iCy, iRadius, iStartAngle, true);
+    // equal angles make a full circle:
+    QPointF endPos = qFuzzyCompare(fmod(iEndAngle - iStartAngle, 360) + 1, 1) ?
+                startPos : PdmAlgorithmUtil::getPosByCircleAngle(iCx, iCy, iRadius, iEndAngle, true);
+    GraphicsPrimitive &primitive = getCurrentPrimitive();
+    primitive.segments.addArc(QPointF(iCx, iCy), iRadius, startPos, endPos, iType == "G02");
 }
 
-void DxfCreationAdapter::addPrimitiveArc(const QString &iPrimitiveName, const QPointF &iCenter, const QPointF &iStartPos,
-                                         const QPointF &iEndPos, const QString &iType)
+void DxfCreationAdapter::addPrimitiveArc(const QPointF &iCenter, const QPointF &iStartPos, const QPointF &iEndPos,
+                                         const QString &iType)
 {
-    addPrimitiveArc(iPrimitiveName, iCenter.x(), iCenter.y(), QLineF(iCenter, iEndPos).length(),
-                 QLineF(iCenter, iStartPos).angle(), QLineF(iCenter, iEndPos).angle(), iType);
+    GraphicsPrimitive &primitive = getCurrentPrimitive();
+    primitive.segments.addArc(iCenter, QLineF(iCenter, iEndPos).length(), iStartPos, iEndPos, iType == "G02");
 }
 
 void DxfCreationAdapter::addPrimitivePolyline(const QPointF &iStartPos, const QPointF &iEndPos, qreal iBluge)
 {
-    qreal bluge = iBluge;
-    QPointF startPos = iStartPos;
-    QPointF endPos = iEndPos;
-    if (bluge == 0 || QLineF(iStartPos, iEndPos).length() < 0.1) {
-        addPrimitiveLine(attributes.getLayer().c_str(), startPos.x(), startPos.y(), endPos.x(), endPos.y());
+    GraphicsPrimitive &primitive = getPolylinePrimitive();
+    if (iBluge == 0 || QLineF(iStartPos, iEndPos).length() < 0.1) {
+        primitive.segments.addLine(iStartPos, iEndPos);
     } else {
-        qreal dis = QLineF(startPos, endPos).length();
-        qreal radius = (dis / 4) * (bluge + (1/bluge));
-        //已知半径和两点求圆心
-        qreal R = qAbs(radius);
-        qreal x1 = startPos.x();
-        qreal y1= startPos.y();
-        qreal x2 = endPos.x();
-        qreal y2 = endPos.y();
-        double c1 = (x2*x2 - x1*x1 + y2*y2 - y1*y1) / (2 *(x2 - x1));
-        double c2 = (y2 - y1) / (x2 - x1);  //斜率
-        double A = (c2*c2 + 1);
-        double B = (2 * x1*c2 - 2 * c1*c2 - 2 * y1);
-        double C = x1*x1 - 2 * x1*c1 + c1*c1 + y1*y1 - R*R;
-        qreal cy1 = (-B + sqrt(B*B - 4 * A*C)) / (2 * A);
-        qreal cy2 = (-B - sqrt(B*B - 4 * A*C)) / (2 * A);
-        qreal y = 0;
-        qreal tolerance = 0.0001;
-        if (startPos.x() + tolerance < endPos.x()) {
-            y = cy1 > cy2 ? cy1 : cy2;
-        } else if (startPos.x() - tolerance > endPos.x()) {
-            y = cy1 < cy2 ? cy1 : cy2;
-        } else {
-            qreal cx1 = c1 - c2 * cy1;
-            qreal cx2 = c1 - c2 * cy2;
-            if (startPos.y() < endPos.y()) {
-                y = cx1 > cx2 ? cy1 : cy2;
-            } else {
-                y = cx1 < cx2 ? cy1 : cy2;
-            }
-        }
-        QString type = "G03";
-        if (bluge < 0) {
-            y = y == cy1 ? cy2 : cy1;
-            type = "G02";
-        }
-        qreal x = c1 - c2 * y;
-        addPrimitiveArc(attributes.getLayer().c_str(), QPointF(x, y), startPos, endPos, type);
+        QPointF center = getBulgeCenter(iStartPos, iEndPos, iBluge);
+        primitive.segments.addArc(center, QLineF(center, iEndPos).length(), iStartPos, iEndPos, iBluge < 0);
     }
 }
-
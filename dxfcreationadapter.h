@@ -3,10 +3,15 @@
 
 #include <QStringList>
 #include <QMap>
+#include <QSet>
+#include <QHash>
 #include <QPointF>
 #include <QPainterPath>
+#include <QVector>
 #include "thirdparty/dxflib/dl_creationadapter.h"
 
+class QDataStream;
+
 struct GraphicsItem {
     QString name;
     QPointF pos;
@@ -16,11 +21,91 @@ struct GraphicsItem {
     qreal sy = 1;
     /*! Rotation angle in degrees. */
     qreal angle = 0;
+    /*! Array of the block (MINSERT): counts and spacing of the columns and rows,
+     *  along the x and y axis of the rotated, unscaled insert. */
+    int columns = 1;
+    int rows = 1;
+    qreal columnSpacing = 0;
+    qreal rowSpacing = 0;
+};
+
+/*! A line or circular arc, kept exact from the DXF entity to the Gerber output. */
+struct GraphicsSegment {
+    enum Type {
+        LineSegment,
+        ArcSegment
+    };
+    Type type = LineSegment;
+    QPointF start;
+    QPointF end;
+    /*! Center and radius of arcs. An arc with start == end is a full circle. */
+    QPointF center;
+    qreal radius = 0;
+    bool clockwise = false;
+
+    /*! Appends the segment to ioPath, arcs as Bezier curves. */
+    void appendTo(QPainterPath &ioPath) const;
+};
+
+/*! The lines and arcs of a layer or block in contiguous arrays: a kind per segment, start and end
+ *  point of every segment and center and radius of every arc. Iterating yields GraphicsSegment
+ *  values. Copies share the arrays until one of them is changed. */
+class GraphicsSegments
+{
+public:
+    class const_iterator
+    {
+    public:
+        GraphicsSegment operator*() const;
+        const_iterator &operator++();
+        bool operator!=(const const_iterator &iOther) const { return mIndex != iOther.mIndex; }
+    private:
+        friend class GraphicsSegments;
+        const GraphicsSegments *mSegments = nullptr;
+        int mIndex = 0;
+        int mArc = 0;
+    };
+
+    /*! Makes room for iSegments segments, iArcs of them arcs. */
+    void reserve(int iSegments, int iArcs);
+    void addLine(const QPointF &iStart, const QPointF &iEnd);
+    void addArc(const QPointF &iCenter, qreal iRadius, const QPointF &iStart, const QPointF &iEnd, bool iClockwise);
+    void append(const GraphicsSegments &iSegments);
+    void clear();
+
+    int count() const { return mKinds.count(); }
+    int arcCount() const { return mRadii.count(); }
+    bool isEmpty() const { return mKinds.isEmpty(); }
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    friend QDataStream &operator<<(QDataStream &ioStream, const GraphicsSegments &iSegments);
+    friend QDataStream &operator>>(QDataStream &ioStream, GraphicsSegments &oSegments);
+
+    enum Kind : quint8 {
+        LineKind,
+        ArcKind,
+        ClockwiseArcKind
+    };
+    QVector<quint8> mKinds;
+    /*! Start and end point of every segment. */
+    QVector<QPointF> mPoints;
+    QVector<QPointF> mCenters;
+    QVector<qreal> mRadii;
 };
 
 struct GraphicsPrimitive {
     QString name;
+    /*! Lines and arcs. */
+    GraphicsSegments segments;
+    /*! Free-form curves (ellipses), fitted with arcs for the output. */
     QPainterPath path;
+    /*! Filled areas (solid hatches), one path per hatch with a closed
+     *  subpath per boundary loop. Nested loops alternate between filled
+     *  and empty. */
+    QVector<QPainterPath> regions;
     QVector<GraphicsItem> items;
 };
 
@@ -34,8 +119,19 @@ public:
     DxfCreationAdapter();
     QMap<QString, GraphicsPrimitive> getAllLayers();
     QMap<QString, GraphicsPrimitive> getAllBlock();
+    /*! Move the collected layers / blocks out of the adapter, without copying them. */
+    QMap<QString, GraphicsPrimitive> takeAllLayers();
+    QMap<QString, GraphicsPrimitive> takeAllBlocks();
     GraphicsPrimitive getBlock(const QString &iName);
 
+    /*! Only entities on these layers are collected, all if empty. Entities
+     *  inside blocks are always collected. */
+    void setLayerFilter(const QStringList &iLayers);
+    QStringList getLayerFilter() const;
+
+    /*! Also resolves the ID of the entity's layer, once per layer change. */
+    void setAttributes(const DL_Attributes &iAttributes) override;
+
     void addLayer(const DL_LayerData &iData) override;
 
     void addPoint(const DL_PointData &iData) override;
@@ -47,6 +143,8 @@ public:
 
     void addPolyline(const DL_PolylineData &iData) override;
     void addVertex(const DL_VertexData &iData) override;
+    /*! All vertices of a light weight polyline in one call. */
+    void addVertices(const DL_VertexData *iData, int iCount) override;
 
     virtual void addBlock(const DL_BlockData &iData) override;
     virtual void endBlock() override;
@@ -56,25 +154,51 @@ public:
 
     virtual void addInsert(const DL_InsertData &iData);
 
+    void addHatch(const DL_HatchData &iData) override;
+    void addHatchBoundary(const DL_HatchBoundary &iBoundary) override;
+
     void printAttributes();
 
     GraphicsPrimitive &getGraphicsPrimitive(const QString &iPrimitiveName);
-    void addPrimitiveLine(const QString &iPrimitiveName, qreal iX1, qreal iY1, qreal iX2, qreal iY2);
-    void addPrimitiveArc(const QString &iPrimitiveName, qreal iCx, qreal iCy, qreal iRadius,
+    /*! The primitives below are added to the current block, or to the layer of the current entity. */
+    void addPrimitiveLine(qreal iX1, qreal iY1, qreal iX2, qreal iY2);
+    void addPrimitiveArc(qreal iCx, qreal iCy, qreal iRadius,
                       qreal iStartAngle, qreal iEndAngle, const QString &iType = "G03");
-    void addPrimitiveArc(const QString &iPrimitiveName, const QPointF &iCenter, const QPointF &iStartPos,
+    void addPrimitiveArc(const QPointF &iCenter, const QPointF &iStartPos,
                       const QPointF &iEndPos, const QString &iType = "G03");
+    /*! Added to the primitive of the polyline being read, whatever layer its vertices name. */
     void addPrimitivePolyline(const QPointF &iStartPos, const QPointF &iEndPos, qreal iBluge);
 
 private:
-    QString mBlockName;
+    bool isLayerSkipped();
+    void updateCurrentLayer();
+    GraphicsPrimitive &getCurrentPrimitive();
+    GraphicsPrimitive &getPolylinePrimitive();
+    QPainterPath getHatchLoopPath(const DL_HatchBoundary &iBoundary, size_t iLoop);
+
     DL_VertexData mFirstVertex;
     DL_VertexData mLastVertex;
     bool mIsFirstVertex = true;
     bool mIsClosePoly = false;
     ItemMode mCurrentMode = NoneMode;
-    QMap<QString, GraphicsPrimitive> mLayers;
-    QMap<QString, GraphicsPrimitive> mBlockItems;
+    bool mIsSkippedPoly = false;
+    /*! Layer and block IDs of the polyline being read, resolved once at addPolyline(). */
+    int mPolyLayer = -1;
+    int mPolyBlock = -1;
+    bool mIsSolidHatch = false;
+    QSet<QString> mLayerFilter;
+    /*! Layers and blocks by their IDs, the IDs are given out by name on first use. */
+    QVector<GraphicsPrimitive> mLayers;
+    QHash<QString, int> mLayerIds;
+    QVector<GraphicsPrimitive> mBlockItems;
+    QHash<QString, int> mBlockIds;
+    /*! Layer name of the last attributes and its ID, -1 if the layer is filtered out
+     *  or no attributes are set yet. */
+    std::string mCurrentLayerName;
+    int mCurrentLayer = -1;
+    bool mIsCurrentLayerValid = false;
+    /*! ID of the block being read, -1 outside of blocks. */
+    int mCurrentBlock = -1;
 };
 
 #endif // CUSTOM_DXF_CREATION_ADAPTER_H
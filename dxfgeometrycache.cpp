@@ -0,0 +1,214 @@
+#include "dxfgeometrycache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "thirdparty/dxflib/dl_dxf.h"
+
+// Increase when the adapter or the layout below changes, old entries then miss:
+#define DXFGEOMETRYCACHE_VERSION 4
+
+static const quint32 cacheMagic = 0x44584743; // "DXGC"
+static const QString cacheSuffix = ".dxfgeo";
+
+QDataStream &operator<<(QDataStream &ioStream, const GraphicsItem &iItem)
+{
+    return ioStream << iItem.name << iItem.pos << iItem.sx << iItem.sy << iItem.angle
+                    << qint32(iItem.columns) << qint32(iItem.rows) << iItem.columnSpacing << iItem.rowSpacing;
+}
+
+QDataStream &operator>>(QDataStream &ioStream, GraphicsItem &oItem)
+{
+    qint32 columns = 1;
+    qint32 rows = 1;
+    ioStream >> oItem.name >> oItem.pos >> oItem.sx >> oItem.sy >> oItem.angle
+             >> columns >> rows >> oItem.columnSpacing >> oItem.rowSpacing;
+    oItem.columns = columns;
+    oItem.rows = rows;
+    return ioStream;
+}
+
+// the arrays of the segments are written as they are:
+QDataStream &operator<<(QDataStream &ioStream, const GraphicsSegments &iSegments)
+{
+    return ioStream << iSegments.mKinds << iSegments.mPoints << iSegments.mCenters << iSegments.mRadii;
+}
+
+QDataStream &operator>>(QDataStream &ioStream, GraphicsSegments &oSegments)
+{
+    ioStream >> oSegments.mKinds >> oSegments.mPoints >> oSegments.mCenters >> oSegments.mRadii;
+    // the iterator relies on consistent arrays:
+    int arcs = oSegments.mKinds.count() - oSegments.mKinds.count(GraphicsSegments::LineKind);
+    if (oSegments.mPoints.count() != 2 * oSegments.mKinds.count() || oSegments.mCenters.count() != arcs
+            || oSegments.mRadii.count() != arcs) {
+        oSegments.clear();
+        ioStream.setStatus(QDataStream::ReadCorruptData);
+    }
+    return ioStream;
+}
+
+QDataStream &operator<<(QDataStream &ioStream, const GraphicsPrimitive &iPrimitive)
+{
+    return ioStream << iPrimitive.name << iPrimitive.segments << iPrimitive.path << iPrimitive.regions
+                    << iPrimitive.items;
+}
+
+QDataStream &operator>>(QDataStream &ioStream, GraphicsPrimitive &oPrimitive)
+{
+    return ioStream >> oPrimitive.name >> oPrimitive.segments >> oPrimitive.path >> oPrimitive.regions
+                    >> oPrimitive.items;
+}
+
+DxfGeometryCache::DxfGeometryCache(const QString &iDir)
+    : mDir(iDir)
+{
+    if (mDir.isEmpty()) {
+        mDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/geometry";
+    }
+}
+
+QString DxfGeometryCache::getDir() const
+{
+    return mDir;
+}
+
+void DxfGeometryCache::setMaxSize(qint64 iBytes)
+{
+    mMaxSize = iBytes;
+}
+
+qint64 DxfGeometryCache::getMaxSize() const
+{
+    return mMaxSize;
+}
+
+QByteArray DxfGeometryCache::getKey(const QString &iDxfFileName) const
+{
+    QFile file(iDxfFileName);
+    if (!file.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray(DL_VERSION));
+    hash.addData(QByteArray::number(DXFGEOMETRYCACHE_VERSION));
+    qint64 size = file.size();
+    uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (data) {
+        // addData() takes an int size:
+        const qint64 blockSize = 1 << 30;
+        for (qint64 pos = 0; pos < size; pos += blockSize) {
+            hash.addData(reinterpret_cast<const char *>(data) + pos, int(qMin(blockSize, size - pos)));
+        }
+        file.unmap(data);
+    } else if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result().toHex();
+}
+
+bool DxfGeometryCache::load(const QByteArray &iKey, QMap<QString, GraphicsPrimitive> *oLayers,
+                            QMap<QString, GraphicsPrimitive> *oBlocks)
+{
+    QFile file(getFileName(iKey));
+    if (iKey.isEmpty() || file.size() <= 0 || !file.open(QFile::ReadOnly)) {
+        ++mMisses;
+        return false;
+    }
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        ++mMisses;
+        return false;
+    }
+
+    // decoded in place from the mapping, the bytes aren't copied:
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(file.size()));
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray key;
+    stream >> magic >> version >> key;
+    QMap<QString, GraphicsPrimitive> layers;
+    QMap<QString, GraphicsPrimitive> blocks;
+    bool ok = magic == cacheMagic && version == DXFGEOMETRYCACHE_VERSION && key == iKey;
+    if (ok) {
+        stream >> layers >> blocks;
+        ok = stream.status() == QDataStream::Ok;
+    }
+    file.unmap(data);
+    if (!ok) {
+        ++mMisses;
+        return false;
+    }
+
+    // the modification time orders the entries for the eviction:
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    *oLayers = layers;
+    *oBlocks = blocks;
+    ++mHits;
+    return true;
+}
+
+bool DxfGeometryCache::store(const QByteArray &iKey, const QMap<QString, GraphicsPrimitive> &iLayers,
+                             const QMap<QString, GraphicsPrimitive> &iBlocks)
+{
+    if (iKey.isEmpty() || !QDir().mkpath(mDir)) {
+        return false;
+    }
+    // written to a temporary file first, a reader never sees half an entry:
+    QSaveFile file(getFileName(iKey));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << cacheMagic << quint32(DXFGEOMETRYCACHE_VERSION) << iKey << iLayers << iBlocks;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        return false;
+    }
+    evict();
+    return true;
+}
+
+int DxfGeometryCache::getHits() const
+{
+    return mHits;
+}
+
+int DxfGeometryCache::getMisses() const
+{
+    return mMisses;
+}
+
+int DxfGeometryCache::getEvictions() const
+{
+    return mEvictions;
+}
+
+QString DxfGeometryCache::getFileName(const QByteArray &iKey) const
+{
+    return mDir + "/" + QString::fromLatin1(iKey) + cacheSuffix;
+}
+
+void DxfGeometryCache::evict()
+{
+    if (mMaxSize <= 0) {
+        return;
+    }
+    // least recently used first:
+    QFileInfoList entries = QDir(mDir).entryInfoList(QStringList("*" + cacheSuffix), QDir::Files,
+                                                     QDir::Time | QDir::Reversed);
+    qint64 size = 0;
+    for (const QFileInfo &entry: entries) {
+        size += entry.size();
+    }
+    for (int i = 0; i < entries.size() && size > mMaxSize; ++i) {
+        if (QFile::remove(entries[i].absoluteFilePath())) {
+            size -= entries[i].size();
+            ++mEvictions;
+        }
+    }
+}
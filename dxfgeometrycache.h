@@ -0,0 +1,48 @@
+#ifndef DXFGEOMETRYCACHE_H
+#define DXFGEOMETRYCACHE_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include "dxfcreationadapter.h"
+
+/*! On-disk cache of the geometry DxfCreationAdapter collects from a DXF file.
+ *
+ *  Entries are keyed by a hash of the file contents, the dxflib version and the
+ *  cache format version, so a changed file or parser never hits an old entry.
+ *  An entry is read through a memory mapping of its file. When the cache grows
+ *  beyond its size limit, the least recently used entries are removed. */
+class DxfGeometryCache
+{
+public:
+    /*! Cache in iDir, in the application's cache location if empty. */
+    explicit DxfGeometryCache(const QString &iDir = QString());
+
+    QString getDir() const;
+    /*! Size limit of all entries in bytes, no limit if 0. */
+    void setMaxSize(qint64 iBytes);
+    qint64 getMaxSize() const;
+
+    /*! @return Key of the file iDxfFileName, empty if it can't be read. */
+    QByteArray getKey(const QString &iDxfFileName) const;
+    bool load(const QByteArray &iKey, QMap<QString, GraphicsPrimitive> *oLayers,
+              QMap<QString, GraphicsPrimitive> *oBlocks);
+    bool store(const QByteArray &iKey, const QMap<QString, GraphicsPrimitive> &iLayers,
+               const QMap<QString, GraphicsPrimitive> &iBlocks);
+
+    int getHits() const;
+    int getMisses() const;
+    int getEvictions() const;
+
+private:
+    QString getFileName(const QByteArray &iKey) const;
+    void evict();
+
+    QString mDir;
+    qint64 mMaxSize = 256 * 1024 * 1024;
+    int mHits = 0;
+    int mMisses = 0;
+    int mEvictions = 0;
+};
+
+#endif // DXFGEOMETRYCACHE_H
@@ -0,0 +1,147 @@
+#include "gerberconverter.h"
+#include <QDir>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include "blockflattener.h"
+#include "painterpath2gerber.h"
+
+/*! @return A relative estimate of the time it takes to write iPrimitive, without its inserts. */
+static qint64 getPrimitiveCost(const GraphicsPrimitive &iPrimitive)
+{
+    qint64 cost = iPrimitive.segments.count() + iPrimitive.segments.arcCount();
+    // curves are fitted with arcs first:
+    cost += 16 * iPrimitive.path.elementCount();
+    // regions are flattened and their contours tested against each other:
+    for (const QPainterPath &region: iPrimitive.regions) {
+        cost += 8 * region.elementCount();
+    }
+    return cost;
+}
+
+/*! One layer, flattened and written by a thread of the pool. */
+class GerberLayerTask : public QRunnable
+{
+public:
+    QString name;
+    const GraphicsPrimitive *layer = nullptr;
+    const QMap<QString, GraphicsPrimitive> *blockItems = nullptr;
+    /*! Only read by the tasks, all blocks are flattened before and missing ones aren't memoized. */
+    BlockFlattener *flattener = nullptr;
+    QString fileName;
+    bool isBlockApertures = false;
+    /*! Results, read after the pool is done. */
+    GraphicsPrimitive flattenedLayer;
+    bool isWritten = true;
+
+    void run() override
+    {
+        flattenedLayer = flattener->getFlattenedPrimitive(*layer);
+        if (flattenedLayer.segments.isEmpty() && flattenedLayer.path.isEmpty() && flattenedLayer.regions.isEmpty()) {
+            return;
+        }
+        QFile file(fileName);
+        isWritten = file.open(QFile::WriteOnly);
+        if (isWritten) {
+            // streamed to the file, without the whole output in memory:
+            PainterPath2Gerber gerber;
+            isWritten = isBlockApertures ? gerber.writeGerber(*layer, *blockItems, &file)
+                                         : gerber.writeGerber(flattenedLayer, QMap<QString, GraphicsPrimitive>(), &file);
+        }
+    }
+};
+
+GerberConverter::GerberConverter(const QMap<QString, GraphicsPrimitive> &iLayers,
+                                 const QMap<QString, GraphicsPrimitive> &iBlockItems)
+    : mLayers(iLayers), mBlockItems(iBlockItems)
+{
+}
+
+void GerberConverter::setOutputDir(const QString &iDir)
+{
+    mOutputDir = iDir;
+}
+
+QString GerberConverter::getOutputDir() const
+{
+    return mOutputDir;
+}
+
+void GerberConverter::setBlockApertures(bool iIsBlockApertures)
+{
+    mIsBlockApertures = iIsBlockApertures;
+}
+
+void GerberConverter::setThreadCount(int iThreads)
+{
+    mThreadCount = iThreads;
+}
+
+bool GerberConverter::convert()
+{
+    mFlattenedLayers.clear();
+    mFailedFiles.clear();
+    // every block is flattened up front, the tasks then only read the flattener:
+    BlockFlattener flattener(mBlockItems);
+    QMap<QString, qint64> blockCosts;
+    for (auto it = mBlockItems.constBegin(); it != mBlockItems.constEnd(); ++it) {
+        blockCosts.insert(it.key(), getPrimitiveCost(flattener.getFlattenedBlock(it.key())));
+    }
+
+    QVector<GerberLayerTask *> tasks;
+    QVector<qint64> costs;
+    QDir dir(mOutputDir);
+    for (auto it = mLayers.constBegin(); it != mLayers.constEnd(); ++it) {
+        GerberLayerTask *task = new GerberLayerTask;
+        // deleted below, after the results are taken:
+        task->setAutoDelete(false);
+        task->name = it.key();
+        task->layer = &it.value();
+        task->blockItems = &mBlockItems;
+        task->flattener = &flattener;
+        task->fileName = dir.filePath(it.key() + ".gbr");
+        task->isBlockApertures = mIsBlockApertures;
+        qint64 cost = getPrimitiveCost(it.value());
+        for (const GraphicsItem &item: it.value().items) {
+            cost += blockCosts.value(item.name) * item.columns * item.rows;
+        }
+        tasks.append(task);
+        costs.append(cost);
+    }
+
+    // the longest first, the short ones then fill the gaps:
+    QVector<int> order(tasks.count());
+    for (int i = 0; i < order.count(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&costs](int iA, int iB) {
+        return costs.at(iA) > costs.at(iB);
+    });
+    QThreadPool pool;
+    pool.setMaxThreadCount(mThreadCount > 0 ? mThreadCount : QThread::idealThreadCount());
+    for (int i: order) {
+        pool.start(tasks.at(i));
+    }
+    pool.waitForDone();
+
+    for (GerberLayerTask *task: tasks) {
+        mFlattenedLayers.insert(task->name, task->flattenedLayer);
+        if (!task->isWritten) {
+            mFailedFiles.append(task->fileName);
+        }
+        delete task;
+    }
+    return mFailedFiles.isEmpty();
+}
+
+QMap<QString, GraphicsPrimitive> GerberConverter::getFlattenedLayers() const
+{
+    return mFlattenedLayers;
+}
+
+QStringList GerberConverter::getFailedFiles() const
+{
+    return mFailedFiles;
+}
@@ -0,0 +1,42 @@
+#ifndef GERBERCONVERTER_H
+#define GERBERCONVERTER_H
+
+#include <QMap>
+#include <QStringList>
+#include "dxfcreationadapter.h"
+
+/*! Writes every layer into a Gerber file of its own. The layers don't depend on each other,
+ *  so they are flattened and written in parallel on a thread pool. The layers with the
+ *  highest cost estimate start first, so a huge layer doesn't start last and hold up the end. */
+class GerberConverter
+{
+public:
+    GerberConverter(const QMap<QString, GraphicsPrimitive> &iLayers, const QMap<QString, GraphicsPrimitive> &iBlockItems);
+
+    /*! Files are named <layer>.gbr in iDir. */
+    void setOutputDir(const QString &iDir);
+    QString getOutputDir() const;
+    /*! Writes every block once as a block aperture instead of flattening its inserts. */
+    void setBlockApertures(bool iIsBlockApertures);
+    /*! Threads of the pool, as many as the machine has cores if 0. */
+    void setThreadCount(int iThreads);
+
+    /*! Writes the files of all layers with geometry.
+     *  @return False if a file couldn't be written, see getFailedFiles(). */
+    bool convert();
+
+    /*! @return The layers with their inserts flattened, after convert(). */
+    QMap<QString, GraphicsPrimitive> getFlattenedLayers() const;
+    QStringList getFailedFiles() const;
+
+private:
+    QMap<QString, GraphicsPrimitive> mLayers;
+    QMap<QString, GraphicsPrimitive> mBlockItems;
+    QString mOutputDir;
+    bool mIsBlockApertures = false;
+    int mThreadCount = 0;
+    QMap<QString, GraphicsPrimitive> mFlattenedLayers;
+    QStringList mFailedFiles;
+};
+
+#endif // GERBERCONVERTER_H
@@ -5,60 +5,101 @@
 #include <QLabel>
 #include <QGraphicsView>
 #include <QGraphicsPathItem>
+#include <QThread>
 #include <QDebug>
 #include "thirdparty/dxflib/dl_dxf.h"
-#include "painterpath2gerber.h"
-
-QPainterPath getGraphicsItemPath(const GraphicsPrimitive &iItem, const QMap<QString, GraphicsPrimitive> &iBlockItems) {
-    QPainterPath path = iItem.path;
-    for (GraphicsItem item: iItem.items) {
-        QPainterPath itemPath = getGraphicsItemPath(iBlockItems[item.name], iBlockItems);
-        QTransform trans;
-        trans.translate(item.pos.x(), item.pos.y());
-        trans.rotate(item.angle);
-        trans.scale(item.sx, item.sy);
-        path.addPath(trans.map(itemPath));
-    }
-    return path;
-}
+#include "dxfgeometrycache.h"
+#include "gerberconverter.h"
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    DxfCreationAdapter *creationAdapter = new DxfCreationAdapter();
-    DL_Dxf *dxf = new DL_Dxf();
-    QFile file("d:\\demo.dxf");
-    if (file.open(QFile::ReadOnly)) {
-        std::stringstream stream;
-        stream << file.readAll().toStdString();
-        if (!dxf->in(stream, creationAdapter)) {
-            std::cerr << "could not be opened.\n";
+    QString fileName = "d:\\demo.dxf";
+    // layers to convert, all if none are given:
+    QStringList layerFilter = a.arguments().mid(1);
+    // writes every block once as a block aperture instead of flattening its inserts:
+    bool isBlockApertures = layerFilter.removeAll("--block-apertures") > 0;
+    QMap<QString, GraphicsPrimitive> layers;
+    QMap<QString, GraphicsPrimitive> blocks;
+    DxfGeometryCache cache;
+    QByteArray cacheKey = cache.getKey(fileName);
+    bool loaded = cache.load(cacheKey, &layers, &blocks);
+    if (!loaded) {
+        DxfCreationAdapter *creationAdapter = new DxfCreationAdapter();
+        DL_Dxf *dxf = new DL_Dxf();
+        dxf->setEntityThreads(QThread::idealThreadCount());
+        // header, objects and unused tables are not needed for the gerber output:
+        dxf->setGeometryOnly(true);
+        dxf->setProgressCallback([](const DL_ProgressData &iProgress) {
+            qDebug() << "read" << iProgress.bytes << "of" << iProgress.totalBytes << "bytes,"
+                     << iProgress.entities << "entities in" << iProgress.elapsed << "s";
+        }, 16 * 1024 * 1024);
+        // entities on other layers are skipped while parsing:
+        if (!layerFilter.isEmpty()) {
+            std::set<std::string> layerNames;
+            for (const QString &layerName: layerFilter) {
+                layerNames.insert(layerName.toStdString());
+            }
+            dxf->setLayerFilter(layerNames);
+            creationAdapter->setLayerFilter(layerFilter);
+        }
+        loaded = dxf->inMapped(QFile::encodeName(fileName).constData(), creationAdapter);
+        if (loaded) {
+            layers = creationAdapter->takeAllLayers();
+            blocks = creationAdapter->takeAllBlocks();
+            // only a parse of all layers serves any layer filter later on:
+            if (layerFilter.isEmpty()) {
+                cache.store(cacheKey, layers, blocks);
+            }
+        }
+        delete dxf;
+        delete creationAdapter;
+    }
+    qDebug() << "geometry cache hits:" << cache.getHits() << "misses:" << cache.getMisses()
+             << "evictions:" << cache.getEvictions();
+    if (!loaded) {
+        std::cerr << "could not be opened.\n";
+    } else {
+        if (!layerFilter.isEmpty()) {
+            for (auto it = layers.begin(); it != layers.end();) {
+                if (layerFilter.contains(it.key())) {
+                    ++it;
+                } else {
+                    it = layers.erase(it);
+                }
+            }
         }
-        QString dir = "c:";
-        QMap<QString, GraphicsPrimitive> layers = creationAdapter->getAllLayers();
-        QMap<QString, GraphicsPrimitive> blocks = creationAdapter->getAllBlock();
-        QMapIterator<QString, GraphicsPrimitive> i(layers);
+        GerberConverter converter(layers, blocks);
+        converter.setOutputDir("c:");
+        converter.setBlockApertures(isBlockApertures);
+        if (!converter.convert()) {
+            for (const QString &fileName: converter.getFailedFiles()) {
+                std::cerr << "could not write " << fileName.toLocal8Bit().constData() << "\n";
+            }
+        }
+        QMapIterator<QString, GraphicsPrimitive> i(converter.getFlattenedLayers());
         QGraphicsView *view = new QGraphicsView;
         QGraphicsScene *scene = new QGraphicsScene;
         view->setScene(scene);
         while (i.hasNext()) {
             i.next();
-            QPainterPath path = getGraphicsItemPath(i.value(), blocks);
-            if (!path.isEmpty()) {
-                QFile file(QString("%1\\%2.gbr").arg(dir).arg(QString(i.key().toLocal8Bit())));
-                if (file.open(QFile::WriteOnly)) {
-                    file.write(PainterPath2Gerber().path2GerberStr(path).toUtf8());
-                }
-                QTransform trans;
-                trans.scale(3,3);
-                path = trans.map(path);
-                scene->addItem(new QGraphicsPathItem(path));
+            const GraphicsPrimitive &primitive = i.value();
+            QPainterPath path = primitive.path;
+            for (const GraphicsSegment &segment: primitive.segments) {
+                segment.appendTo(path);
+            }
+            QTransform trans;
+            trans.scale(3,3);
+            path = trans.map(path);
+            scene->addItem(new QGraphicsPathItem(path));
+            for (const QPainterPath &region: primitive.regions) {
+                QGraphicsPathItem *regionItem = new QGraphicsPathItem(trans.map(region));
+                regionItem->setBrush(Qt::black);
+                scene->addItem(regionItem);
             }
         }
         view->show();
     }
-    delete dxf;
-    delete creationAdapter;
 //    return a.exec();
     return 0;
 }
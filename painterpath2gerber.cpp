@@ -1,23 +1,386 @@
 #include "painterpath2gerber.h"
 #include <QRegularExpression>
+#include <QBuffer>
+#include <QFile>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "pdmalgorithmutil.h"
 #include "beziercurve2arcs/beziercurvetoarcs.h"
 
-const QRegularExpression expX("X([+-]?\\d+)");
-const QRegularExpression expY("Y([+-]?\\d+)");
+/*! Room for one formatted number (sign and up to 20 digits) and for a site. */
+static const int numberCapacity = 24;
+static const int siteCapacity = 2 * numberCapacity + 2;
+
+static char *appendText(char *oText, const char *iText, int iSize)
+{
+    memcpy(oText, iText, iSize);
+    return oText + iSize;
+}
+
+/*! Gerber files are plain ASCII. */
+static char *appendText(char *oText, const QString &iText)
+{
+    const QChar *text = iText.constData();
+    for (int i = 0; i < iText.size(); ++i) {
+        *oText++ = text[i].toLatin1();
+    }
+    return oText;
+}
 
 PainterPath2Gerber::PainterPath2Gerber()
+    : mBuffer(64 * 1024, Qt::Uninitialized)
+{
+}
+
+QString PainterPath2Gerber::path2GerberStr(const QPainterPath &iPath, const QVector<QPainterPath> &iRegions)
+{
+    GraphicsPrimitive primitive;
+    primitive.path = iPath;
+    primitive.regions = iRegions;
+    return path2GerberStr(primitive);
+}
+
+QString PainterPath2Gerber::path2GerberStr(const GraphicsPrimitive &iPrimitive)
+{
+    // without blocks every insert is left out:
+    return path2GerberStr(iPrimitive, QMap<QString, GraphicsPrimitive>());
+}
+
+QString PainterPath2Gerber::path2GerberStr(const GraphicsPrimitive &iPrimitive,
+                                           const QMap<QString, GraphicsPrimitive> &iBlockItems)
+{
+    QByteArray gerber;
+    QBuffer buffer(&gerber);
+    buffer.open(QIODevice::WriteOnly);
+    writeGerber(iPrimitive, iBlockItems, &buffer);
+    return QString::fromLatin1(gerber);
+}
+
+bool PainterPath2Gerber::writeGerber(const GraphicsPrimitive &iPrimitive,
+                                     const QMap<QString, GraphicsPrimitive> &iBlockItems, QIODevice *oDevice)
+{
+    mDevice = oDevice;
+    mBufferSize = 0;
+    mIsFirstCommand = true;
+    mIsWriteError = false;
+    addGerberFile(iPrimitive, iBlockItems);
+    flush();
+    mDevice = nullptr;
+    return !mIsWriteError;
+}
+
+bool PainterPath2Gerber::writeGerber(const GraphicsPrimitive &iPrimitive,
+                                     const QMap<QString, GraphicsPrimitive> &iBlockItems, int iFd)
+{
+    QFile file;
+    // the buffer below is all the buffering needed:
+    if (!file.open(iFd, QIODevice::WriteOnly | QIODevice::Unbuffered, QFileDevice::DontCloseHandle)) {
+        return false;
+    }
+    return writeGerber(iPrimitive, iBlockItems, &file);
+}
+
+void PainterPath2Gerber::addGerberFile(const GraphicsPrimitive &iPrimitive,
+                                       const QMap<QString, GraphicsPrimitive> &iBlockItems)
 {
+    mBlockItems = iBlockItems;
+    mFlattener = BlockFlattener(iBlockItems);
+    mBlockApertures.clear();
+    mNextAperture = 11;
+    mIsMirrored = false;
+    mRotation = "0";
+    mScale = "1";
+    mIsPositionKnown = false;
+    addCommand(QString("%FSTAX%1%2Y%1%2*%").arg(mIntegerDigits).arg(mDecimalDigits));
+    addCommand("%MOIN*%");
+    addCommand("%ADD10C,0.00100*%");
+    addCommand("G75*");
+    addGerberBlocks(iPrimitive.items);
+    addCommand("G54D10*");
+    mAperture = 10;
+    addGerberPrimitive(iPrimitive);
+    // a step and repeat can't be used inside a block aperture:
+    addGerberItems(iPrimitive.items, true);
+    addCommand("M02*");
+}
+
+/*! Adds iCommand, one without coordinates, to the output buffer on a line of its own. */
+void PainterPath2Gerber::addCommand(const QString &iCommand)
+{
+    endCommand(appendText(beginCommand(iCommand.size()), iCommand));
+    // to be safe, the next draw moves there first:
+    mIsPositionKnown = false;
+}
+
+/*! Adds the command iCode, the site iX, iY and iOperation (e.g. D02*), which ends at that site. */
+void PainterPath2Gerber::addSiteCommand(const char *iCode, qint64 iX, qint64 iY, const char *iOperation)
+{
+    char *command = beginCommand(siteCapacity + 16);
+    command = appendText(command, iCode, strlen(iCode));
+    command += formatSite(iX, iY, command);
+    endCommand(appendText(command, iOperation, strlen(iOperation)));
+    setPosition(iX, iY);
+}
+
+/*! @return Where to write a command of at most iMaxSize chars into the output buffer. The
+ *  buffer is written to the device whenever it is full, so the output never has to fit
+ *  into memory. */
+char *PainterPath2Gerber::beginCommand(int iMaxSize)
+{
+    if (mBufferSize + iMaxSize + 1 > mBuffer.size()) {
+        flush();
+        if (iMaxSize + 1 > mBuffer.size()) {
+            mBuffer.resize(iMaxSize + 1);
+        }
+    }
+    char *command = mBuffer.data() + mBufferSize;
+    if (!mIsFirstCommand) {
+        *command++ = '\n';
+    }
+    mIsFirstCommand = false;
+    return command;
+}
+
+void PainterPath2Gerber::endCommand(const char *iEnd)
+{
+    mBufferSize = iEnd - mBuffer.constData();
+}
+
+void PainterPath2Gerber::setPosition(qint64 iX, qint64 iY)
+{
+    mX = iX;
+    mY = iY;
+    mIsPositionKnown = true;
+}
+
+bool PainterPath2Gerber::isPosition(qint64 iX, qint64 iY) const
+{
+    return mIsPositionKnown && mX == iX && mY == iY;
+}
+
+/*! @return iNumber (mm) in inch, scaled to an integer of mDecimalDigits decimals. It is
+ *  rounded half away from zero from its exact binary value, like QString::number() does. */
+qint64 PainterPath2Gerber::getCoordinate(qreal iNumber) const
+{
+    static const qreal powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    qreal number = std::fabs(iNumber / 25.4);
+    qreal scaled = number * powers[mDecimalDigits];
+    qint64 value = 0;
+    if (scaled < 9e18) {
+        // the rounding error of the scaling decides ties:
+        qreal error = std::fma(number, powers[mDecimalDigits], -scaled);
+        qreal whole = std::floor(scaled);
+        value = qint64(whole) + ((scaled - whole - 0.5) + error >= 0 ? 1 : 0);
+    } else if (scaled == scaled) {
+        // beyond any board:
+        value = Q_INT64_C(999999999999999999);
+    }
+    return iNumber < 0 ? -value : value;
+}
+
+/*! Writes iCoordinate as %FS asks for: the integer digits with leading zeros up to
+ *  mIntegerDigits, then the decimals without their trailing zeros.
+ *  @return The count of chars written to oDigits, at most numberCapacity. */
+int PainterPath2Gerber::formatCoordinate(qint64 iCoordinate, char *oDigits) const
+{
+    char digits[numberCapacity];
+    int count = 0;
+    quint64 value = iCoordinate < 0 ? quint64(-iCoordinate) : quint64(iCoordinate);
+    for (quint64 rest = value; rest > 0 || count < mIntegerDigits + mDecimalDigits; rest /= 10) {
+        digits[count++] = char('0' + rest % 10);
+    }
+    int trailingZeros = 0;
+    while (trailingZeros < mDecimalDigits && digits[trailingZeros] == '0') {
+        ++trailingZeros;
+    }
+    char *text = oDigits;
+    if (iCoordinate < 0) {
+        *text++ = '-';
+    }
+    for (int i = count - 1; i >= trailingZeros; --i) {
+        *text++ = digits[i];
+    }
+    return text - oDigits;
+}
+
+int PainterPath2Gerber::formatSite(qint64 iX, qint64 iY, char *oSite) const
+{
+    char *site = oSite;
+    *site++ = 'X';
+    site += formatCoordinate(iX, site);
+    *site++ = 'Y';
+    site += formatCoordinate(iY, site);
+    return site - oSite;
+}
+
+void PainterPath2Gerber::flush()
+{
+    if (mBufferSize > 0 && mDevice && !mIsWriteError) {
+        mIsWriteError = mDevice->write(mBuffer.constData(), mBufferSize) != mBufferSize;
+    }
+    mBufferSize = 0;
+}
+
+/*! Writes the geometry of iPrimitive, without the blocks it inserts, with the current aperture. */
+void PainterPath2Gerber::addGerberPrimitive(const GraphicsPrimitive &iPrimitive)
+{
+    // regions first, the strokes are drawn over them:
+    for (const QPainterPath &region: iPrimitive.regions) {
+        addGerberRegion(region);
+    }
+    addGerberSegments(iPrimitive.segments);
+    addGerberPath(iPrimitive.path);
+}
+
+/*! Defines the blocks inserted by iItems as block apertures, the blocks they insert first. */
+void PainterPath2Gerber::addGerberBlocks(const QVector<GraphicsItem> &iItems)
+{
+    for (const GraphicsItem &item: iItems) {
+        if (mBlockApertures.contains(item.name)) {
+            continue;
+        }
+        // a block inserting itself finds itself empty:
+        mBlockApertures.insert(item.name, 0);
+        GraphicsPrimitive block = mBlockItems.value(item.name);
+        addGerberBlocks(block.items);
+        bool isEmpty = block.segments.isEmpty() && block.path.isEmpty() && block.regions.isEmpty();
+        for (const GraphicsItem &blockItem: block.items) {
+            isEmpty = isEmpty && mBlockApertures.value(blockItem.name) == 0;
+        }
+        if (isEmpty) {
+            continue;
+        }
+        int aperture = mNextAperture++;
+        addCommand(QString("%ABD%1*%").arg(aperture));
+        addCommand("D10*");
+        mAperture = 10;
+        addGerberPrimitive(block);
+        addGerberItems(block.items);
+        addCommand("%AB*%");
+        mAperture = 0;
+        mBlockApertures.insert(item.name, aperture);
+    }
+}
+
+/*! Checks whether the elements of the array iItem line up along the x and y axis, as a
+ *  step and repeat needs them. oFirst is the element with the smallest coordinates. */
+static bool getStepAndRepeat(const GraphicsItem &iItem, GraphicsItem *oFirst, int *oCountX, int *oCountY,
+                             qreal *oStepX, qreal *oStepY)
+{
+    QTransform rotation;
+    rotation.rotate(iItem.angle);
+    QPointF column = rotation.map(QPointF(iItem.columns > 1 ? iItem.columnSpacing : 0, 0));
+    QPointF row = rotation.map(QPointF(0, iItem.rows > 1 ? iItem.rowSpacing : 0));
+    if (qAbs(column.y()) < 1e-9 && qAbs(row.x()) < 1e-9) {
+        *oCountX = iItem.columns;
+        *oCountY = iItem.rows;
+        *oStepX = column.x();
+        *oStepY = row.y();
+    } else if (qAbs(column.x()) < 1e-9 && qAbs(row.y()) < 1e-9) {
+        *oCountX = iItem.rows;
+        *oCountY = iItem.columns;
+        *oStepX = row.x();
+        *oStepY = column.y();
+    } else {
+        return false;
+    }
+    // the repeats run in positive direction:
+    *oFirst = iItem;
+    oFirst->pos += QPointF(qMin(0.0, (*oCountX - 1) * *oStepX), qMin(0.0, (*oCountY - 1) * *oStepY));
+    oFirst->columns = 1;
+    oFirst->rows = 1;
+    *oStepX = qAbs(*oStepX);
+    *oStepY = qAbs(*oStepY);
+    return true;
+}
+
+/*! Flashes the block apertures of iItems, inserts that aperture transformations can't
+ *  express are flattened and drawn with D10. Arrays are written as a step and repeat if
+ *  iIsRepeatable is set, else element by element. */
+void PainterPath2Gerber::addGerberItems(const QVector<GraphicsItem> &iItems, bool iIsRepeatable)
+{
+    for (const GraphicsItem &item: iItems) {
+        int aperture = mBlockApertures.value(item.name);
+        if (aperture == 0) {
+            continue;
+        }
+        GraphicsItem first;
+        int countX = 1;
+        int countY = 1;
+        qreal stepX = 0;
+        qreal stepY = 0;
+        if (qFuzzyCompare(qAbs(item.sx), qAbs(item.sy))) {
+            if (iIsRepeatable && item.columns * item.rows > 1
+                    && getStepAndRepeat(item, &first, &countX, &countY, &stepX, &stepY)) {
+                addCommand(QString("%SRX%1Y%2I%3J%4*%").arg(countX).arg(countY)
+                                  .arg(doubleToStr(stepX / 25.4, 6)).arg(doubleToStr(stepY / 25.4, 6)));
+                addGerberFlash(aperture, first);
+                addCommand("%SR*%");
+            } else {
+                for (const GraphicsItem &element: BlockFlattener::getArrayItems(item)) {
+                    addGerberFlash(aperture, element);
+                }
+            }
+        } else {
+            GraphicsPrimitive primitive;
+            GraphicsPrimitive block = mFlattener.getFlattenedBlock(item.name);
+            for (const GraphicsItem &element: BlockFlattener::getArrayItems(item)) {
+                BlockFlattener::addMappedPrimitive(primitive, block, BlockFlattener::getItemTransform(element));
+            }
+            // the transformation would scale D10 as well:
+            setApertureTransform(false, 0, 1);
+            setAperture(10);
+            addGerberPrimitive(primitive);
+        }
+    }
+    setApertureTransform(false, 0, 1);
+    setAperture(10);
+}
+
+/*! Flashes iAperture at the position of iItem, moved, mirrored, rotated and scaled like it. */
+void PainterPath2Gerber::addGerberFlash(int iAperture, const GraphicsItem &iItem)
+{
+    // the mirroring comes first, then the rotation, a negative y scale is a mirrored x
+    // scale turned by 180 degrees:
+    qreal rotation = fmod(iItem.angle + (iItem.sy < 0 ? 180 : 0), 360);
+    setApertureTransform((iItem.sx < 0) != (iItem.sy < 0), rotation < 0 ? rotation + 360 : rotation,
+                         qAbs(iItem.sx));
+    setAperture(iAperture);
+    addSiteCommand("", getCoordinate(iItem.pos.x()), getCoordinate(iItem.pos.y()), "D03*");
+}
+
+void PainterPath2Gerber::setAperture(int iAperture)
+{
+    if (mAperture != iAperture) {
+        addCommand(QString("D%1*").arg(iAperture));
+        mAperture = iAperture;
+    }
+}
+
+/*! Sets the aperture transformation (%LM, %LR, %LS) for the following flashes, iRotation
+ *  counterclockwise in degrees. Only changes are written. */
+void PainterPath2Gerber::setApertureTransform(bool iMirror, qreal iRotation, qreal iScale)
+{
+    if (mIsMirrored != iMirror) {
+        mIsMirrored = iMirror;
+        addCommand(mIsMirrored ? "%LMX*%" : "%LMN*%");
+    }
+    QString rotation = doubleToStr(iRotation, 4);
+    if (mRotation != rotation) {
+        mRotation = rotation;
+        addCommand(QString("%LR%1*%").arg(mRotation));
+    }
+    QString scale = doubleToStr(iScale, 6);
+    if (mScale != scale) {
+        mScale = scale;
+        addCommand(QString("%LS%1*%").arg(mScale));
+    }
 }
 
-QString PainterPath2Gerber::path2GerberStr(const QPainterPath &iPath)
+void PainterPath2Gerber::addGerberPath(const QPainterPath &iPath)
 {
     QPointF lastPos;
-    mGerberStr.append("%FSTAX34Y34*%");
-    mGerberStr.append("%MOIN*%");
-    mGerberStr.append("%ADD10C,0.00100*%");
-    mGerberStr.append("G75*");
-    mGerberStr.append("G54D10*");
     for (int i = 0; i < iPath.elementCount(); ++i) {
         QPainterPath::Element element = iPath.elementAt(i);
         QPointF pos(element.x, element.y);
@@ -33,14 +396,326 @@ QString PainterPath2Gerber::path2GerberStr(const QPainterPath &iPath)
                     addGerberArc(arc.center.x(), arc.center.y(), arc.radius, arc.startAngle / M_PI * 180,
                                  arc.endAngle / M_PI * 180, arc.clockwiseFlag ? "G02" : "G03");
                 }
+            } else if (mIsContour) {
+                // a contour must stay closed:
+                addGerberLine(lastPos.x(), lastPos.y(), pos.x(), pos.y());
             }
         } else if (element.type == QPainterPath::LineToElement) {
             addGerberLine(lastPos.x(), lastPos.y(), pos.x(), pos.y());
+        } else if (mIsContour) {
+            addSiteCommand("", getCoordinate(pos.x()), getCoordinate(pos.y()), "D02*");
         }
         lastPos = pos;
     }
-    mGerberStr.append("M02*");
-    return mGerberStr.join("\n");
+}
+
+/*! Writes lines and arcs as they are, one G02/G03 per arc. */
+void PainterPath2Gerber::addGerberSegments(const GraphicsSegments &iSegments)
+{
+    for (const GraphicsSegment &segment: iSegments) {
+        if (segment.type == GraphicsSegment::LineSegment) {
+            addGerberLine(segment.start.x(), segment.start.y(), segment.end.x(), segment.end.y());
+            continue;
+        }
+        QString type = segment.clockwise ? "G02" : "G03";
+        QPointF start = segment.start - segment.center;
+        QPointF end = segment.end - segment.center;
+        // the sweep in the direction of the arc, equal end points make a full circle:
+        qreal sweep = 2 * M_PI;
+        if (segment.start != segment.end) {
+            sweep = atan2(end.y(), end.x()) - atan2(start.y(), start.x());
+            if (segment.clockwise) {
+                sweep = -sweep;
+            }
+            if (sweep <= 0) {
+                sweep += 2 * M_PI;
+            }
+        }
+        if (sweep > M_PI) {
+            // the end points of a large arc may round to the same site, which would make
+            // it vanish, so it is written in two halves:
+            qreal half = segment.clockwise ? -sweep / 2 : sweep / 2;
+            QPointF middle = segment.center + QPointF(start.x() * cos(half) - start.y() * sin(half),
+                                                      start.x() * sin(half) + start.y() * cos(half));
+            addGerberArc(segment.center, segment.start, middle, type);
+            addGerberArc(segment.center, middle, segment.end, type);
+        } else {
+            // at most a half circle, it's tiny if its end points round to the same site:
+            addGerberArc(segment.center, segment.start, segment.end, type);
+        }
+    }
+}
+
+/*! A closed subpath of a region: its start point and the lines and cubic curves from there.
+ *  The last element ends at the start point. */
+struct RegionContour
+{
+    struct Element
+    {
+        bool isCurve;
+        QPointF controlA;
+        QPointF controlB;
+        QPointF end;
+    };
+    QPointF start;
+    QVector<Element> elements;
+};
+
+/*! @return The subpaths of iRegion, each closed. */
+static QVector<RegionContour> getRegionContours(const QPainterPath &iRegion)
+{
+    QVector<RegionContour> contours;
+    for (int i = 0; i < iRegion.elementCount(); ++i) {
+        QPainterPath::Element element = iRegion.elementAt(i);
+        if (element.type == QPainterPath::MoveToElement) {
+            contours.append(RegionContour());
+            contours.last().start = QPointF(element.x, element.y);
+        } else if (contours.isEmpty()) {
+            continue;
+        } else if (element.type == QPainterPath::LineToElement) {
+            contours.last().elements.append({false, QPointF(), QPointF(), QPointF(element.x, element.y)});
+        } else if (element.type == QPainterPath::CurveToElement && i + 2 < iRegion.elementCount()) {
+            QPainterPath::Element controlB = iRegion.elementAt(i + 1);
+            QPainterPath::Element end = iRegion.elementAt(i + 2);
+            contours.last().elements.append({true, QPointF(element.x, element.y), QPointF(controlB.x, controlB.y),
+                                             QPointF(end.x, end.y)});
+            i += 2;
+        }
+    }
+    QVector<RegionContour> closedContours;
+    for (RegionContour &contour: contours) {
+        if (contour.elements.isEmpty()) {
+            continue;
+        }
+        if (contour.elements.last().end != contour.start) {
+            contour.elements.append({false, QPointF(), QPointF(), contour.start});
+        }
+        closedContours.append(contour);
+    }
+    return closedContours;
+}
+
+/*! @return The start point of element iIndex of iContour. */
+static QPointF getContourVertex(const RegionContour &iContour, int iIndex)
+{
+    return iIndex == 0 ? iContour.start : iContour.elements.at(iIndex - 1).end;
+}
+
+/*! @return iContour as a polygon, curves flattened finely enough to test what crosses them. */
+static QPolygonF getContourPolygon(const RegionContour &iContour)
+{
+    QPolygonF polygon;
+    polygon.append(iContour.start);
+    for (int i = 0; i < iContour.elements.count(); ++i) {
+        const RegionContour::Element &element = iContour.elements.at(i);
+        if (element.isCurve) {
+            QPointF start = getContourVertex(iContour, i);
+            for (int step = 1; step < 16; ++step) {
+                qreal t = step / 16.0;
+                qreal u = 1 - t;
+                polygon.append(u * u * u * start + 3 * u * u * t * element.controlA
+                               + 3 * u * t * t * element.controlB + t * t * t * element.end);
+            }
+        }
+        polygon.append(element.end);
+    }
+    return polygon;
+}
+
+/*! @return The area of iPolygon, negative if it runs clockwise. */
+static qreal getSignedArea(const QPolygonF &iPolygon)
+{
+    qreal area = 0;
+    for (int i = 0; i < iPolygon.count(); ++i) {
+        const QPointF &p1 = iPolygon.at(i);
+        const QPointF &p2 = iPolygon.at((i + 1) % iPolygon.count());
+        area += p1.x() * p2.y() - p2.x() * p1.y();
+    }
+    return area / 2;
+}
+
+static RegionContour getReversedContour(const RegionContour &iContour)
+{
+    RegionContour reversed;
+    reversed.start = iContour.start;
+    for (int i = iContour.elements.count() - 1; i >= 0; --i) {
+        const RegionContour::Element &element = iContour.elements.at(i);
+        reversed.elements.append({element.isCurve, element.controlB, element.controlA, getContourVertex(iContour, i)});
+    }
+    return reversed;
+}
+
+/*! @return iContour starting at the start point of element iIndex. */
+static RegionContour getRotatedContour(const RegionContour &iContour, int iIndex)
+{
+    RegionContour rotated;
+    rotated.start = getContourVertex(iContour, iIndex);
+    rotated.elements = iContour.elements.mid(iIndex) + iContour.elements.mid(0, iIndex);
+    return rotated;
+}
+
+static QPainterPath getContourPath(const RegionContour &iContour)
+{
+    QPainterPath path(iContour.start);
+    for (const RegionContour::Element &element: iContour.elements) {
+        if (element.isCurve) {
+            path.cubicTo(element.controlA, element.controlB, element.end);
+        } else {
+            path.lineTo(element.end);
+        }
+    }
+    return path;
+}
+
+static qreal getCrossProduct(const QPointF &iA, const QPointF &iB)
+{
+    return iA.x() * iB.y() - iA.y() * iB.x();
+}
+
+/*! @return True if the lines iA-iB and iC-iD cross each other. */
+static bool isCrossing(const QPointF &iA, const QPointF &iB, const QPointF &iC, const QPointF &iD)
+{
+    qreal c = getCrossProduct(iB - iA, iC - iA);
+    qreal d = getCrossProduct(iB - iA, iD - iA);
+    qreal a = getCrossProduct(iD - iC, iA - iC);
+    qreal b = getCrossProduct(iD - iC, iB - iC);
+    return ((c > 0 && d < 0) || (c < 0 && d > 0)) && ((a > 0 && b < 0) || (a < 0 && b > 0));
+}
+
+static bool isCrossing(const QLineF &iLine, const QPolygonF &iPolygon)
+{
+    for (int i = 0; i + 1 < iPolygon.count(); ++i) {
+        if (isCrossing(iLine.p1(), iLine.p2(), iPolygon.at(i), iPolygon.at(i + 1))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*! @return True if iLine runs inside iPolygon and outside of iHoles, without crossing them or iCutIns. */
+static bool isCutInFree(const QLineF &iLine, const QPolygonF &iPolygon, const QVector<QPolygonF> &iHoles,
+                        const QVector<QLineF> &iCutIns)
+{
+    QPointF middle = iLine.pointAt(0.5);
+    if (!iPolygon.containsPoint(middle, Qt::OddEvenFill) || isCrossing(iLine, iPolygon)) {
+        return false;
+    }
+    for (const QPolygonF &hole: iHoles) {
+        if (hole.containsPoint(middle, Qt::OddEvenFill) || isCrossing(iLine, hole)) {
+            return false;
+        }
+    }
+    for (const QLineF &cutIn: iCutIns) {
+        if (isCrossing(iLine.p1(), iLine.p2(), cutIn.p1(), cutIn.p2())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! Joins iHole into ioContour by a cut-in: a line from a vertex of ioContour to a vertex of
+ *  iHole, once around the hole and back along the same line. The shortest line that runs
+ *  inside iPolygon, the outline of ioContour, and crosses none of iHoles and ioCutIns is taken. */
+static void addCutIn(RegionContour &ioContour, const RegionContour &iHole, const QPolygonF &iPolygon,
+                     const QVector<QPolygonF> &iHoles, QVector<QLineF> *ioCutIns)
+{
+    struct CutIn
+    {
+        qreal length;
+        int vertex;
+        int holeVertex;
+    };
+    QVector<CutIn> cutIns;
+    cutIns.reserve(ioContour.elements.count() * iHole.elements.count());
+    for (int i = 0; i < ioContour.elements.count(); ++i) {
+        for (int j = 0; j < iHole.elements.count(); ++j) {
+            QPointF line = getContourVertex(iHole, j) - getContourVertex(ioContour, i);
+            cutIns.append({QPointF::dotProduct(line, line), i, j});
+        }
+    }
+    std::sort(cutIns.begin(), cutIns.end(), [](const CutIn &iA, const CutIn &iB) {
+        return iA.length < iB.length;
+    });
+    // without a free line, e.g. for a hole crossing its contour, the shortest one:
+    CutIn cutIn = cutIns.first();
+    for (const CutIn &candidate: cutIns) {
+        QLineF line(getContourVertex(ioContour, candidate.vertex), getContourVertex(iHole, candidate.holeVertex));
+        if (isCutInFree(line, iPolygon, iHoles, *ioCutIns)) {
+            cutIn = candidate;
+            break;
+        }
+    }
+
+    QPointF from = getContourVertex(ioContour, cutIn.vertex);
+    RegionContour hole = getRotatedContour(iHole, cutIn.holeVertex);
+    QVector<RegionContour::Element> elements = ioContour.elements.mid(0, cutIn.vertex);
+    elements.append({false, QPointF(), QPointF(), hole.start});
+    elements += hole.elements;
+    elements.append({false, QPointF(), QPointF(), from});
+    elements += ioContour.elements.mid(cutIn.vertex);
+    ioContour.elements = elements;
+    ioCutIns->append(QLineF(from, hole.start));
+}
+
+/*! Writes iRegion as one G36/G37 region statement. Subpaths inside an odd number of other
+ *  subpaths are holes. Each hole is joined into the contour around it by a cut-in, so the
+ *  region is written in dark polarity and clears nothing but its own holes. */
+void PainterPath2Gerber::addGerberRegion(const QPainterPath &iRegion)
+{
+    QVector<RegionContour> contours = getRegionContours(iRegion);
+    if (contours.isEmpty()) {
+        return;
+    }
+    QVector<QPolygonF> polygons;
+    for (const RegionContour &contour: contours) {
+        polygons.append(getContourPolygon(contour));
+    }
+    // the number of contours around each one, odd for holes, and the one it lies in directly:
+    QVector<int> depths(contours.count(), 0);
+    QVector<int> parents(contours.count(), -1);
+    for (int i = 0; i < contours.count(); ++i) {
+        for (int j = 0; j < contours.count(); ++j) {
+            if (i != j && polygons[j].containsPoint(polygons[i].first(), Qt::OddEvenFill)) {
+                ++depths[i];
+            }
+        }
+    }
+    for (int i = 0; i < contours.count(); ++i) {
+        for (int j = 0; j < contours.count(); ++j) {
+            if (depths[j] == depths[i] - 1 && polygons[j].containsPoint(polygons[i].first(), Qt::OddEvenFill)) {
+                parents[i] = j;
+            }
+        }
+    }
+
+    mIsContour = true;
+    addCommand("G36*");
+    for (int i = 0; i < contours.count(); ++i) {
+        if (depths[i] % 2 == 1) {
+            continue;
+        }
+        RegionContour contour = contours[i];
+        QVector<QPolygonF> holes;
+        for (int j = 0; j < contours.count(); ++j) {
+            if (parents[j] == i) {
+                holes.append(polygons[j]);
+            }
+        }
+        QVector<QLineF> cutIns;
+        bool isClockwise = getSignedArea(polygons[i]) < 0;
+        for (int j = 0; j < contours.count(); ++j) {
+            if (parents[j] != i) {
+                continue;
+            }
+            // a hole runs against its contour, so it stays empty with either fill rule:
+            RegionContour hole = (getSignedArea(polygons[j]) < 0) == isClockwise ? getReversedContour(contours[j])
+                                                                                 : contours[j];
+            addCutIn(contour, hole, polygons[i], holes, &cutIns);
+        }
+        addGerberPath(getContourPath(contour));
+    }
+    addCommand("G37*");
+    mIsContour = false;
 }
 
 QString PainterPath2Gerber::doubleToStr(qreal iNum, int iPrecision)
@@ -68,59 +743,27 @@ QString PainterPath2Gerber::prependZeroByDecimals(const QString &iNumber, int iD
 
 QString PainterPath2Gerber::getNumberStr(qreal iNumber)
 {
-    qreal number = iNumber / 25.4;
-    QStringList numberStr = doubleToStr(number, 4).split(".");
-    QString numberIntStr = prependZeroByDecimals(numberStr.first(), 3);
-    if (numberStr.count() == 2) {
-        numberIntStr += numberStr.last();
-    }
-    return numberIntStr;
+    char number[numberCapacity];
+    return QString::fromLatin1(number, formatCoordinate(getCoordinate(iNumber), number));
 }
 
 QString PainterPath2Gerber::getSiteStr(qreal iX, qreal iY)
 {
-    QString xStr = getNumberStr(iX);
-    QString yStr = getNumberStr(iY);
-    return QString("X%1Y%2").arg(xStr).arg(yStr);
-}
-
-bool PainterPath2Gerber::getNumber(const QString &iStr, const QRegularExpression &iReg, qreal *oNumber)
-{
-    QRegularExpressionMatch regMatch = iReg.match(iStr);
-    QString matchStr = regMatch.hasMatch() ? regMatch.captured() : "";
-    bool result = false;
-    if (!matchStr.isEmpty()) {
-        QRegularExpression numberReg("[+-]?\\d+");
-        regMatch = numberReg.match(matchStr);
-        matchStr = regMatch.hasMatch() ? regMatch.captured() : "";
-        if (!matchStr.isEmpty()) {
-            *oNumber = matchStr.toDouble();
-            result = true;
-        }
-    }
-    return result;
-}
-
-bool PainterPath2Gerber::siteIsEquality(const QString &iSite1, const QString &iSite2)
-{
-    qreal x1,x2,y1,y2 = 0;
-    qreal result = false;
-    if (getNumber(iSite1, expX, &x1) && getNumber(iSite1, expY, &y1)
-            &&getNumber(iSite2, expX, &x2) && getNumber(iSite2, expY, &y2)) {
-        result = (x1 == x2) && (y1==y2);
-    }
-    return result;
+    char site[siteCapacity];
+    return QString::fromLatin1(site, formatSite(getCoordinate(iX), getCoordinate(iY), site));
 }
 
 void PainterPath2Gerber::addGerberLine(qreal iX1, qreal iY1, qreal iX2, qreal iY2)
 {
-    QString lastSite = getSiteStr(iX1, iY1);
-    if (siteIsEquality(lastSite, mGerberStr.last()) == false) {
-        mGerberStr.append(QString("%1D02*").arg(lastSite));
+    qint64 x1 = getCoordinate(iX1);
+    qint64 y1 = getCoordinate(iY1);
+    if (!mIsContour && !isPosition(x1, y1)) {
+        addSiteCommand("", x1, y1, "D02*");
     }
-    QString site = getSiteStr(iX2, iY2);
-    if (site != lastSite) {
-        mGerberStr.append(QString("G01%1D01*").arg(site));
+    qint64 x2 = getCoordinate(iX2);
+    qint64 y2 = getCoordinate(iY2);
+    if (x2 != x1 || y2 != y1) {
+        addSiteCommand("G01", x2, y2, "D01*");
     }
 }
 
@@ -133,15 +776,22 @@ void PainterPath2Gerber::addGerberArc(qreal iCx, qreal iCy, qreal iRadius, qreal
 
 void PainterPath2Gerber::addGerberArc(const QPointF &iCenter, const QPointF &iStartPos, const QPointF &iEndPos, const QString &iType)
 {
-    QString lastSite = getSiteStr(iStartPos.x(), iStartPos.y());
-    if (siteIsEquality(lastSite, mGerberStr.last()) == false) {
-        mGerberStr.append(QString("%1D02*").arg(lastSite));
+    qint64 x1 = getCoordinate(iStartPos.x());
+    qint64 y1 = getCoordinate(iStartPos.y());
+    if (!mIsContour && !isPosition(x1, y1)) {
+        addSiteCommand("", x1, y1, "D02*");
     }
-    QString site = getSiteStr(iEndPos.x(), iEndPos.y());
-    if (site != lastSite) {
-        qreal i = iCenter.x() - iStartPos.x();
-        qreal j = iCenter.y() - iStartPos.y();
-        mGerberStr.append(QString("%1%2I%3J%4D01*").arg(iType).arg(site)
-                      .arg(getNumberStr(i)).arg(getNumberStr(j)));
+    qint64 x2 = getCoordinate(iEndPos.x());
+    qint64 y2 = getCoordinate(iEndPos.y());
+    if (x2 != x1 || y2 != y1) {
+        char *command = beginCommand(iType.size() + 2 * siteCapacity + 8);
+        command = appendText(command, iType);
+        command += formatSite(x2, y2, command);
+        *command++ = 'I';
+        command += formatCoordinate(getCoordinate(iCenter.x() - iStartPos.x()), command);
+        *command++ = 'J';
+        command += formatCoordinate(getCoordinate(iCenter.y() - iStartPos.y()), command);
+        endCommand(appendText(command, "D01*", 4));
+        setPosition(x2, y2);
     }
 }
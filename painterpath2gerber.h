@@ -2,23 +2,84 @@
 #define DXF2GERBERUTIL_H
 
 #include "dxfcreationadapter.h"
+#include "blockflattener.h"
+
+class QIODevice;
 
 class PainterPath2Gerber
 {
 public:
     PainterPath2Gerber();
-    QString path2GerberStr(const QPainterPath &iPath);
+    QString path2GerberStr(const QPainterPath &iPath, const QVector<QPainterPath> &iRegions = QVector<QPainterPath>());
+    /*! Writes the segments, curves and regions of iPrimitive, its items are ignored. */
+    QString path2GerberStr(const GraphicsPrimitive &iPrimitive);
+    /*! Writes iPrimitive like above, each block it inserts once as a block aperture (%AB) and each
+     *  insert as a flash of it, moved, mirrored, rotated and scaled by %LM, %LR and %LS. Inserts
+     *  scaled differently in x and y can't be expressed that way and are flattened. Arrays of
+     *  inserts along the x and y axis are written as a step and repeat (%SR) of one flash. */
+    QString path2GerberStr(const GraphicsPrimitive &iPrimitive, const QMap<QString, GraphicsPrimitive> &iBlockItems);
+    /*! Writes iPrimitive like path2GerberStr() straight to oDevice, through a fixed buffer of 64 KB.
+     *  @return False if writing failed. */
+    bool writeGerber(const GraphicsPrimitive &iPrimitive, const QMap<QString, GraphicsPrimitive> &iBlockItems,
+                     QIODevice *oDevice);
+    /*! Writes to the open file descriptor iFd, which stays open. */
+    bool writeGerber(const GraphicsPrimitive &iPrimitive, const QMap<QString, GraphicsPrimitive> &iBlockItems,
+                     int iFd);
     QString doubleToStr(qreal iNum, int iPrecision);
     QString prependZeroByDecimals(const QString &iNumber, int iDecimals);
     QString getNumberStr(qreal iNumber);
     QString getSiteStr(qreal iX, qreal iY);
-    bool getNumber(const QString &iStr, const QRegularExpression &iReg, qreal *oNumber);
-    bool siteIsEquality(const QString &iSite1, const QString &iSite2);
     void addGerberLine(qreal iX1, qreal iY1, qreal iX2, qreal iY2);
     void addGerberArc(qreal iCx, qreal iCy, qreal iRadius, qreal iStartAngle, qreal iEndAngle, const QString &iType = "G03");
     void addGerberArc(const QPointF &iCenter, const QPointF &iStartPos, const QPointF &iEndPos, const QString &iType = "G03");
+    void addGerberPath(const QPainterPath &iPath);
+    void addGerberSegments(const GraphicsSegments &iSegments);
+    void addGerberRegion(const QPainterPath &iRegion);
+    void addGerberPrimitive(const GraphicsPrimitive &iPrimitive);
+    void addGerberBlocks(const QVector<GraphicsItem> &iItems);
+    void addGerberItems(const QVector<GraphicsItem> &iItems, bool iIsRepeatable = false);
 private:
-    QStringList mGerberStr;
+    void addGerberFile(const GraphicsPrimitive &iPrimitive, const QMap<QString, GraphicsPrimitive> &iBlockItems);
+    void addGerberFlash(int iAperture, const GraphicsItem &iItem);
+    void addCommand(const QString &iCommand);
+    void addSiteCommand(const char *iCode, qint64 iX, qint64 iY, const char *iOperation);
+    char *beginCommand(int iMaxSize);
+    void endCommand(const char *iEnd);
+    void setPosition(qint64 iX, qint64 iY);
+    bool isPosition(qint64 iX, qint64 iY) const;
+    qint64 getCoordinate(qreal iNumber) const;
+    int formatCoordinate(qint64 iCoordinate, char *oDigits) const;
+    int formatSite(qint64 iX, qint64 iY, char *oSite) const;
+    void flush();
+    void setAperture(int iAperture);
+    void setApertureTransform(bool iMirror, qreal iRotation, qreal iScale);
+
+    /*! Output buffer, the first mBufferSize bytes are used. */
+    QByteArray mBuffer;
+    int mBufferSize = 0;
+    QIODevice *mDevice = nullptr;
+    bool mIsFirstCommand = true;
+    bool mIsWriteError = false;
+    /*! Coordinate format of %FS, in inch. */
+    int mIntegerDigits = 3;
+    int mDecimalDigits = 4;
+    /*! Current point of the plot in %FS coordinates, to leave out D02 moves to where it
+     *  already is. Unknown after commands without coordinates. */
+    qint64 mX = 0;
+    qint64 mY = 0;
+    bool mIsPositionKnown = false;
+    QMap<QString, GraphicsPrimitive> mBlockItems;
+    BlockFlattener mFlattener;
+    /*! D code of the block aperture of every block, 0 for blocks without geometry. */
+    QMap<QString, int> mBlockApertures;
+    int mNextAperture = 11;
+    /*! Current aperture, 0 if unknown, and the current aperture transformation. */
+    int mAperture = 0;
+    bool mIsMirrored = false;
+    QString mRotation = "0";
+    QString mScale = "1";
+    /*! Writing the contours of a region (G36), segments join without D02. */
+    bool mIsContour = false;
 };
 
 #endif // DXF2GERBERUTIL_H
@@ -0,0 +1,14 @@
+QT = core testlib
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_dxflib
+
+TEMPLATE = app
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+include($$PWD/../../../thirdparty/dxflib/dxflib.pri)
+
+SOURCES += tst_dxflib.cpp
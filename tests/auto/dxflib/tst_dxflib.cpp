@@ -0,0 +1,375 @@
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dl_dxf.h"
+#include "dl_creationadapter.h"
+#include "dl_linereader.h"
+
+static const char *demoFile = SRCDIR "../../../demo1.dxf";
+
+/*! @return True for the group codes of double values. */
+static bool isRealCode(int iCode)
+{
+    return (iCode >= 10 && iCode < 60) || (iCode >= 110 && iCode < 150) || (iCode >= 210 && iCode < 240);
+}
+
+/*! Writes every callback with its data into a text, to compare parses with each other. */
+class TraceAdapter : public DL_CreationAdapter
+{
+public:
+    std::string trace;
+
+    void addLayer(const DL_LayerData &iData) override
+    {
+        add("layer", iData.name);
+    }
+    void addBlock(const DL_BlockData &iData) override
+    {
+        add("block", iData.name);
+        add(iData.bpx, iData.bpy);
+    }
+    void endBlock() override
+    {
+        add("endblock");
+    }
+    void addPoint(const DL_PointData &iData) override
+    {
+        add("point");
+        add(iData.x, iData.y);
+    }
+    void addLine(const DL_LineData &iData) override
+    {
+        add("line");
+        add(iData.x1, iData.y1);
+        add(iData.x2, iData.y2);
+    }
+    void addArc(const DL_ArcData &iData) override
+    {
+        add("arc");
+        add(iData.cx, iData.cy);
+        add(iData.radius, iData.angle1);
+        add(iData.angle2, 0);
+    }
+    void addCircle(const DL_CircleData &iData) override
+    {
+        add("circle");
+        add(iData.cx, iData.cy);
+        add(iData.radius, 0);
+    }
+    void addPolyline(const DL_PolylineData &iData) override
+    {
+        add("polyline");
+        add(iData.number, iData.flags);
+    }
+    void addVertex(const DL_VertexData &iData) override
+    {
+        add("vertex");
+        add(iData.x, iData.y);
+        add(iData.bulge, 0);
+    }
+    void addInsert(const DL_InsertData &iData) override
+    {
+        add("insert", iData.name);
+        add(iData.ipx, iData.ipy);
+        add(iData.sx, iData.sy);
+        add(iData.angle, iData.cols * 1000 + iData.rows);
+    }
+    void addText(const DL_TextData &iData) override
+    {
+        add("text", iData.text);
+        add(iData.ipx, iData.ipy);
+        add(iData.height, iData.angle);
+    }
+    void addMText(const DL_MTextData &iData) override
+    {
+        add("mtext", iData.text);
+        add(iData.ipx, iData.ipy);
+    }
+    void addHatch(const DL_HatchData &iData) override
+    {
+        add("hatch", iData.pattern);
+        add(iData.numLoops, iData.solid);
+    }
+    void addHatchLoop(const DL_HatchLoopData &iData) override
+    {
+        add("loop");
+        add(iData.numEdges, 0);
+    }
+    void addHatchEdge(const DL_HatchEdgeData &iData) override
+    {
+        add("edge");
+        add(iData.type, iData.vertices.size());
+        // only the values of the type of edge are set:
+        if (iData.type == 1) {
+            add(iData.x1, iData.y1);
+            add(iData.x2, iData.y2);
+        } else if (iData.type == 2) {
+            add(iData.cx, iData.cy);
+            add(iData.radius, iData.angle1);
+            add(iData.angle2, iData.ccw);
+        }
+        for (const std::vector<double> &vertex: iData.vertices) {
+            add(vertex.size() > 0 ? vertex[0] : 0, vertex.size() > 1 ? vertex[1] : 0);
+        }
+    }
+    void endEntity() override
+    {
+        add("end");
+    }
+    void endSequence() override
+    {
+        add("endsequence");
+    }
+
+private:
+    /*! The name of the callback, the layer of its entity and iText. */
+    void add(const char *iName, const std::string &iText = std::string())
+    {
+        trace += '\n';
+        trace += iName;
+        trace += ' ';
+        trace += attributes.getLayer();
+        trace += ' ';
+        trace += iText;
+    }
+    void add(double iA, double iB)
+    {
+        // %a is exact and doesn't depend on the locale:
+        char numbers[64];
+        snprintf(numbers, sizeof(numbers), " %a %a", iA, iB);
+        trace += numbers;
+    }
+};
+
+/*! @return A drawing with iEntities lines, arcs, circles, polylines, texts and inserts of a
+ *  block on a few layers. Some values use ',' as decimal separator or an exponent. */
+static std::string getDrawing(unsigned int iSeed, int iEntities)
+{
+    std::ostringstream dxf;
+    unsigned int random = iSeed;
+    auto getNumber = [&random]() {
+        random = random * 1103515245 + 12345;
+        double value = int(random >> 8 & 0xfffff) / 1024.0 - 512;
+        char number[32];
+        switch (random >> 28 & 3) {
+        case 0:
+            snprintf(number, sizeof(number), "%.6e", value);
+            break;
+        case 1: {
+                snprintf(number, sizeof(number), "%.4f", value);
+                char *point = strchr(number, '.');
+                if (point) {
+                    *point = ',';
+                }
+                break;
+            }
+        default:
+            snprintf(number, sizeof(number), "%.10f", value);
+            break;
+        }
+        return std::string(number);
+    };
+    auto addPoint = [&dxf, &getNumber](int iCode) {
+        dxf << iCode << "\n" << getNumber() << "\n" << iCode + 10 << "\n" << getNumber() << "\n";
+    };
+    dxf << "0\nSECTION\n2\nBLOCKS\n0\nBLOCK\n8\n0\n2\nPART\n70\n0\n10\n0\n20\n0\n";
+    dxf << "0\nLINE\n8\n0\n";
+    addPoint(10);
+    addPoint(11);
+    dxf << "0\nCIRCLE\n8\n0\n";
+    addPoint(10);
+    dxf << "40\n2.5\n0\nENDBLK\n0\nENDSEC\n";
+    dxf << "0\nSECTION\n2\nENTITIES\n";
+    for (int i = 0; i < iEntities; ++i) {
+        const char *layer = i % 7 == 0 ? "OUTLINE" : (i % 3 == 0 ? "TOP" : "BOTTOM");
+        switch (i % 6) {
+        case 0:
+            dxf << "0\nLINE\n8\n" << layer << "\n";
+            addPoint(10);
+            addPoint(11);
+            break;
+        case 1:
+            dxf << "0\nARC\n8\n" << layer << "\n";
+            addPoint(10);
+            dxf << "40\n" << getNumber() << "\n50\n" << getNumber() << "\n51\n" << getNumber() << "\n";
+            break;
+        case 2:
+            dxf << "0\nCIRCLE\n8\n" << layer << "\n";
+            addPoint(10);
+            dxf << "40\n" << getNumber() << "\n";
+            break;
+        case 3:
+            dxf << "0\nLWPOLYLINE\n8\n" << layer << "\n90\n4\n70\n1\n";
+            for (int k = 0; k < 4; ++k) {
+                addPoint(10);
+                dxf << "42\n" << (k % 2 ? "0" : "0.5") << "\n";
+            }
+            break;
+        case 4:
+            dxf << "0\nTEXT\n8\n" << layer << "\n";
+            addPoint(10);
+            dxf << "40\n1.5\n1\nTEXT " << i << "\n";
+            break;
+        default:
+            dxf << "0\nINSERT\n8\n" << layer << "\n2\nPART\n";
+            addPoint(10);
+            dxf << "41\n2\n42\n2\n50\n" << getNumber() << "\n";
+            break;
+        }
+    }
+    dxf << "0\nENDSEC\n0\nEOF\n";
+    return dxf.str();
+}
+
+/*! @return The content of iFileName, empty if it can't be read. */
+static std::string readFile(const char *iFileName)
+{
+    std::string content;
+    FILE *file = fopen(iFileName, "rb");
+    if (file) {
+        char buffer[64 * 1024];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            content.append(buffer, count);
+        }
+        fclose(file);
+    }
+    return content;
+}
+
+/*! An input of the stress test. Inputs with a file name are also read from the file. */
+struct ParseInput
+{
+    std::string fileName;
+    std::string data;
+    std::string trace;
+};
+
+/*! Parses iInput the way iMode selects: from the file, its mapping, memory or a stream, on the
+ *  calling thread or with worker threads for the entities. */
+static bool parseInput(const ParseInput &iInput, int iMode, std::string *oTrace)
+{
+    DL_Dxf dxf;
+    TraceAdapter adapter;
+    bool ok = false;
+    dxf.setEntityThreads(iMode % 2 ? 2 : 1);
+    switch (iInput.fileName.empty() ? iMode % 2 + 2 : iMode % 4) {
+    case 0:
+        ok = dxf.in(iInput.fileName, &adapter);
+        break;
+    case 1:
+        ok = dxf.inMapped(iInput.fileName, &adapter);
+        break;
+    case 2:
+        ok = dxf.in(iInput.data.data(), iInput.data.size(), &adapter);
+        break;
+    default: {
+            std::stringstream stream(iInput.data);
+            ok = dxf.in(stream, &adapter);
+            break;
+        }
+    }
+    oTrace->swap(adapter.trace);
+    return ok;
+}
+
+class tst_DxfLib : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void numbers();
+    void demoNumbers();
+    void concurrentParse();
+};
+
+/*! The corpus of DL_Dxf::testNumbers(): exponents, signs, ',' as decimal separator. */
+void tst_DxfLib::numbers()
+{
+    QVERIFY(DL_Dxf::testNumbers());
+}
+
+/*! Every double of demo1.dxf converts to the same value as with strtod() in the C locale. */
+void tst_DxfLib::demoNumbers()
+{
+    FILE *file = fopen(demoFile, "rt");
+    QVERIFY(file);
+    DL_LineReader reader;
+    reader.setSource(file);
+    const char *code;
+    size_t codeLength;
+    const char *value;
+    size_t valueLength;
+    int count = 0;
+    while (reader.getStrippedLine(code, codeLength) && reader.getStrippedLine(value, valueLength)) {
+        if (!isRealCode(DL_Dxf::toInt(code, codeLength))) {
+            continue;
+        }
+        std::string str(value, valueLength);
+        std::replace(str.begin(), str.end(), ',', '.');
+        double expected = strtod(str.c_str(), NULL);
+        double real = DL_Dxf::toReal(value, valueLength);
+        QVERIFY2(real == expected && std::signbit(real) == std::signbit(expected), str.c_str());
+        ++count;
+    }
+    fclose(file);
+    QVERIFY(count > 0);
+}
+
+/*! Several DL_Dxf instances parse the same inputs on threads at the same time, each time
+ *  with the same callbacks as a parse on its own. */
+void tst_DxfLib::concurrentParse()
+{
+    std::vector<ParseInput> inputs(4);
+    inputs[0].fileName = demoFile;
+    inputs[0].data = readFile(demoFile);
+    QVERIFY(!inputs[0].data.empty());
+    for (size_t i = 1; i < inputs.size(); ++i) {
+        inputs[i].data = getDrawing(i, 20000 * i);
+    }
+    std::string locale = std::locale().name();
+    for (ParseInput &input: inputs) {
+        QVERIFY(parseInput(input, 2, &input.trace));
+        QVERIFY(input.trace.size() > 1000);
+    }
+    QVERIFY(inputs[1].trace != inputs[2].trace);
+
+    int threadCount = std::max(4, int(std::thread::hardware_concurrency()));
+    // mismatches of each thread, as "input mode", tests may only fail on the main thread:
+    std::vector<std::vector<std::string> > failures(threadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.push_back(std::thread([t, &inputs, &failures]() {
+            for (int round = 0; round < 4; ++round) {
+                for (size_t k = 0; k < inputs.size(); ++k) {
+                    // every thread starts with another input and mode:
+                    size_t i = (k + t) % inputs.size();
+                    int mode = t + round;
+                    std::string trace;
+                    if (!parseInput(inputs[i], mode, &trace) || trace != inputs[i].trace) {
+                        failures[t].push_back(std::to_string(i) + " " + std::to_string(mode % 4));
+                    }
+                }
+            }
+        }));
+    }
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+    for (const std::vector<std::string> &failure: failures) {
+        QVERIFY2(failure.empty(), failure.empty() ? "" : failure.front().c_str());
+    }
+    // the parser leaves the global locale alone:
+    QCOMPARE(std::locale().name(), locale);
+}
+
+QTEST_APPLESS_MAIN(tst_DxfLib)
+
+#include "tst_dxflib.moc"
@@ -0,0 +1,14 @@
+QT = core gui testlib
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_gerber
+
+TEMPLATE = app
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+include($$PWD/../../../dxf2gerber.pri)
+
+SOURCES += tst_gerber.cpp
@@ -0,0 +1,277 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include "thirdparty/dxflib/dl_dxf.h"
+#include "thirdparty/dxflib/dl_binaryreader.h"
+#include "dxfcreationadapter.h"
+#include "gerberconverter.h"
+#include "painterpath2gerber.h"
+
+static const QString demoFile = SRCDIR "../../../demo1.dxf";
+
+/*! Encodings of group values in binary DXF. */
+enum BinaryValueType
+{
+    StringValue,
+    RealValue,
+    Int16Value,
+    Int32Value,
+    Int64Value,
+    BoolValue,
+    BinaryValue
+};
+
+/*! @return The encoding of the value of group iCode, from the group code ranges of the DXF reference. */
+static BinaryValueType getBinaryValueType(int iCode)
+{
+    struct Range
+    {
+        int last;
+        BinaryValueType type;
+    };
+    static const Range ranges[] = {
+        {9, StringValue}, {59, RealValue}, {79, Int16Value}, {89, StringValue}, {99, Int32Value},
+        {109, StringValue}, {149, RealValue}, {159, StringValue}, {169, Int64Value}, {179, Int16Value},
+        {209, StringValue}, {239, RealValue}, {269, StringValue}, {289, Int16Value}, {299, BoolValue},
+        {309, StringValue}, {319, BinaryValue}, {369, StringValue}, {389, Int16Value}, {399, StringValue},
+        {409, Int16Value}, {419, StringValue}, {429, Int32Value}, {439, StringValue}, {459, Int32Value},
+        {469, RealValue}, {999, StringValue}, {1003, StringValue}, {1004, BinaryValue}, {1009, StringValue},
+        {1059, RealValue}, {1070, Int16Value}, {1071, Int32Value}
+    };
+    for (const Range &range: ranges) {
+        if (iCode <= range.last) {
+            return range.type;
+        }
+    }
+    return StringValue;
+}
+
+static void appendLittleEndian(QByteArray &ioData, quint64 iValue, int iSize)
+{
+    for (int i = 0; i < iSize; ++i) {
+        ioData.append(char(iValue >> (8 * i) & 0xff));
+    }
+}
+
+/*! Writes the ASCII DXF iAsciiFile as binary DXF with 2 byte group codes, like a CAD program
+ *  exporting the drawing again. Doubles keep the value their text stands for. */
+static bool writeBinaryDxf(const QString &iAsciiFile, const QString &iBinaryFile)
+{
+    QFile ascii(iAsciiFile);
+    QFile binary(iBinaryFile);
+    if (!ascii.open(QIODevice::ReadOnly) || !binary.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    static const char sentinel[] = "AutoCAD Binary DXF\r\n\x1a";
+    // with its terminating '\0':
+    QByteArray data(sentinel, sizeof(sentinel));
+    while (!ascii.atEnd()) {
+        QByteArray codeLine = ascii.readLine().trimmed();
+        if (codeLine.isEmpty()) {
+            continue;
+        }
+        QByteArray value = ascii.readLine();
+        // values keep their spaces, like in DL_Dxf:
+        while (value.endsWith('\n') || value.endsWith('\r')) {
+            value.chop(1);
+        }
+        bool ok = true;
+        int code = codeLine.toInt(&ok);
+        if (!ok) {
+            return false;
+        }
+        appendLittleEndian(data, code, 2);
+        switch (getBinaryValueType(code)) {
+        case StringValue:
+            data.append(value);
+            data.append('\0');
+            break;
+        case RealValue: {
+                double real = value.trimmed().toDouble(&ok);
+                quint64 bits;
+                memcpy(&bits, &real, sizeof(bits));
+                appendLittleEndian(data, bits, 8);
+                break;
+            }
+        case Int16Value:
+            appendLittleEndian(data, quint16(value.trimmed().toShort(&ok)), 2);
+            break;
+        case Int32Value:
+            appendLittleEndian(data, quint32(value.trimmed().toInt(&ok)), 4);
+            break;
+        case Int64Value:
+            appendLittleEndian(data, quint64(value.trimmed().toLongLong(&ok)), 8);
+            break;
+        case BoolValue:
+            data.append(char(value.trimmed().toInt(&ok) != 0));
+            break;
+        case BinaryValue: {
+                QByteArray bytes = QByteArray::fromHex(value.trimmed());
+                data.append(char(bytes.size()));
+                data.append(bytes);
+                break;
+            }
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return binary.write(data) == data.size();
+}
+
+/*! Converts every layer of iDxfFile into Gerber files in iOutputDir.
+ *  @return The names of the written files, none if reading or writing failed. */
+static QStringList convertDxf(const QString &iDxfFile, const QString &iOutputDir, bool iIsBlockApertures)
+{
+    DxfCreationAdapter adapter;
+    DL_Dxf dxf;
+    if (!dxf.in(QFile::encodeName(iDxfFile).constData(), &adapter) || !QDir().mkpath(iOutputDir)) {
+        return QStringList();
+    }
+    GerberConverter converter(adapter.takeAllLayers(), adapter.takeAllBlocks());
+    converter.setOutputDir(iOutputDir);
+    converter.setBlockApertures(iIsBlockApertures);
+    if (!converter.convert()) {
+        return QStringList();
+    }
+    return QDir(iOutputDir).entryList(QStringList("*.gbr"), QDir::Files, QDir::Name);
+}
+
+static QByteArray readFile(const QString &iFileName)
+{
+    QFile file(iFileName);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/*! How getNumberStr() formatted before formatCoordinate(). */
+static QString getNumberStrOld(PainterPath2Gerber &ioGerber, qreal iNumber)
+{
+    qreal number = iNumber / 25.4;
+    QStringList numberStr = ioGerber.doubleToStr(number, 4).split(".");
+    QString numberIntStr = ioGerber.prependZeroByDecimals(numberStr.first(), 3);
+    if (numberStr.count() == 2) {
+        numberIntStr += numberStr.last();
+    }
+    return numberIntStr;
+}
+
+/*! @return The coordinate iNumber in 1e-4 inch, read like a Gerber reader does with %FSTAX34Y34*%. */
+static qint64 parseNumberStr(const QString &iNumber)
+{
+    bool isNegative = iNumber.startsWith('-');
+    QString digits = iNumber.mid(isNegative ? 1 : 0);
+    // the trailing zeros of the decimals are left out:
+    qint64 value = digits.left(3).toLongLong() * 10000 + digits.mid(3).leftJustified(4, '0').toLongLong();
+    return isNegative ? -value : value;
+}
+
+class tst_Gerber : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void asciiAndBinary_data();
+    void asciiAndBinary();
+    void regions();
+    void numberStr();
+};
+
+void tst_Gerber::asciiAndBinary_data()
+{
+    QTest::addColumn<bool>("blockApertures");
+    QTest::newRow("flattened") << false;
+    QTest::newRow("block apertures") << true;
+}
+
+/*! demo1.dxf and its binary export give the same Gerber files. */
+void tst_Gerber::asciiAndBinary()
+{
+    QFETCH(bool, blockApertures);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString binaryFile = dir.filePath("demo1_binary.dxf");
+    QVERIFY(writeBinaryDxf(demoFile, binaryFile));
+    QByteArray binary = readFile(binaryFile);
+    QVERIFY(DL_BinaryReader::isBinary(binary.constData(), binary.size()));
+
+    QStringList asciiFiles = convertDxf(demoFile, dir.filePath("ascii"), blockApertures);
+    QStringList binaryFiles = convertDxf(binaryFile, dir.filePath("binary"), blockApertures);
+    QVERIFY(!asciiFiles.isEmpty());
+    QCOMPARE(binaryFiles, asciiFiles);
+    for (const QString &fileName: asciiFiles) {
+        QByteArray ascii = readFile(dir.filePath("ascii/" + fileName));
+        QVERIFY2(!ascii.isEmpty(), qPrintable(fileName));
+        QVERIFY2(readFile(dir.filePath("binary/" + fileName)) == ascii, qPrintable(fileName));
+    }
+}
+
+/*! Every hatch is one dark region with its holes cut in, so it can't clear another one. */
+void tst_Gerber::regions()
+{
+    QPainterPath outer;
+    outer.addRect(0, 0, 100, 100);
+    outer.addRect(10, 10, 20, 20);
+    outer.addEllipse(QPointF(70, 70), 15, 15);
+    // an island in the round hole:
+    outer.addEllipse(QPointF(70, 70), 5, 5);
+    QPainterPath overlapping;
+    overlapping.addRect(50, 50, 100, 100);
+    overlapping.addRect(60, 60, 10, 10);
+
+    PainterPath2Gerber gerber;
+    QString str = gerber.path2GerberStr(QPainterPath(), QVector<QPainterPath>() << outer << overlapping);
+    QVERIFY(!str.contains("%LP"));
+    QCOMPARE(str.count("G36*"), 2);
+    QCOMPARE(str.count("G37*"), 2);
+    // the outer contour with both holes cut in and the island, the overlapping one with its hole:
+    QString firstRegion = str.section("G36*", 1, 1).section("G37*", 0, 0);
+    QCOMPARE(firstRegion.count("D02*"), 2);
+    QString secondRegion = str.section("G36*", 2, 2).section("G37*", 0, 0);
+    QCOMPARE(secondRegion.count("D02*"), 1);
+}
+
+/*! getNumberStr() gives what the old QString path gave, apart from values rounding to -0,
+ *  which are written without a sign now. The old path never ends from 1000 inch on. */
+void tst_Gerber::numberStr()
+{
+    // every 1e-4 inch step in +-5 inch, with the values midway and one ulp next to them:
+    QVector<qreal> steps;
+    QVector<qreal> values;
+    for (int i = -50000; i <= 50000; ++i) {
+        qreal step = i * 25.4e-4;
+        qreal midway = (i + 0.5) * 25.4e-4;
+        steps << step;
+        values << step << midway << std::nextafter(midway, -HUGE_VAL) << std::nextafter(midway, HUGE_VAL);
+    }
+    // a 1e-3 mm grid in +-100 mm:
+    for (int i = -100000; i <= 100000; ++i) {
+        values << i * 1e-3;
+    }
+    std::mt19937 random(23);
+    std::uniform_real_distribution<qreal> distribution(-25000, 25000);
+    for (int i = 0; i < 100000; ++i) {
+        values << distribution(random);
+    }
+
+    PainterPath2Gerber gerber;
+    for (qreal value: values) {
+        QString oldStr = getNumberStrOld(gerber, value);
+        QString str = gerber.getNumberStr(value);
+        if (str == oldStr || (str == "000" && oldStr == "-000")) {
+            continue;
+        }
+        QFAIL(qPrintable(QString("%1 mm: %2, was %3").arg(value, 0, 'g', 17).arg(str, oldStr)));
+    }
+    // every step reads back as itself:
+    for (int i = 0; i < steps.count(); ++i) {
+        QCOMPARE(parseNumberStr(gerber.getNumberStr(steps.at(i))), qint64(i - 50000));
+    }
+}
+
+QTEST_GUILESS_MAIN(tst_Gerber)
+
+#include "tst_gerber.moc"
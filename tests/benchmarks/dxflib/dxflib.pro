@@ -0,0 +1,14 @@
+QT = core testlib
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = tst_bench_dxflib
+
+TEMPLATE = app
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+include($$PWD/../../../thirdparty/dxflib/dxflib.pri)
+
+SOURCES += tst_bench_dxflib.cpp
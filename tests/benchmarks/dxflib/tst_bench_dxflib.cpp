@@ -0,0 +1,206 @@
+#include <QtTest>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "dl_dxf.h"
+#include "dl_creationadapter.h"
+#include "dl_linereader.h"
+
+/*! 3 MB, 7.6k LINEs and 2.4k ARCs. */
+static const char *demoFile = SRCDIR "../../../demo1.dxf";
+
+/*! How lines were read before DL_LineReader, a buffer allocated and freed for every line. */
+static bool getStrippedLineOld(std::string &oLine, unsigned int iSize, FILE *iFile, bool iStripSpace = true)
+{
+    if (feof(iFile)) {
+        oLine = "";
+        return false;
+    }
+    char *wholeLine = new char[iSize];
+    char *line = fgets(wholeLine, iSize, iFile);
+    if (line != NULL && line[0] != '\0') {
+        DL_Dxf::stripWhiteSpace(&line, iStripSpace);
+        oLine = line;
+        assert(iSize > oLine.length());
+    }
+    delete[] wholeLine;
+    return true;
+}
+
+/*! How DL_Dxf::toReal() converted before, through a copy and an istringstream. */
+static double toRealOld(const std::string &iStr)
+{
+    double ret;
+    std::string str = iStr;
+    std::replace(str.begin(), str.end(), ',', '.');
+    std::istringstream stream(str);
+    stream >> ret;
+    return ret;
+}
+
+/*! How DL_Dxf::toInt() converted before. */
+static int toIntOld(const std::string &iStr)
+{
+    char *end;
+    return strtol(iStr.c_str(), &end, 10);
+}
+
+class tst_Bench_DxfLib : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void readLinesOld();
+    void readLines();
+    void parse();
+    void parseMapped();
+    void toRealOld();
+    void toReal();
+    void toIntOld();
+    void toInt();
+
+private:
+    /*! The group codes and the double values of demo1.dxf, as in the file. */
+    std::vector<std::string> mCodes;
+    std::vector<std::string> mReals;
+};
+
+void tst_Bench_DxfLib::initTestCase()
+{
+    FILE *file = fopen(demoFile, "rt");
+    QVERIFY(file);
+    DL_LineReader reader;
+    reader.setSource(file);
+    const char *code;
+    size_t codeLength;
+    const char *value;
+    size_t valueLength;
+    while (reader.getStrippedLine(code, codeLength) && reader.getStrippedLine(value, valueLength)) {
+        mCodes.push_back(std::string(code, codeLength));
+        int groupCode = DL_Dxf::toInt(code, codeLength);
+        if ((groupCode >= 10 && groupCode < 60) || (groupCode >= 110 && groupCode < 150)
+                || (groupCode >= 210 && groupCode < 240)) {
+            mReals.push_back(std::string(value, valueLength));
+        }
+    }
+    fclose(file);
+    QVERIFY(!mReals.empty());
+}
+
+/*! Reads the groups of demo1.dxf like readDxfGroups() did before DL_LineReader. */
+void tst_Bench_DxfLib::readLinesOld()
+{
+    long groups = 0;
+    QBENCHMARK {
+        FILE *file = fopen(demoFile, "rt");
+        QVERIFY(file);
+        std::string code;
+        std::string value;
+        groups = 0;
+        while (getStrippedLineOld(code, DL_DXF_MAXLINE, file) &&
+               getStrippedLineOld(value, DL_DXF_MAXLINE, file, false)) {
+            ++groups;
+        }
+        fclose(file);
+    }
+    QVERIFY(groups > 0);
+}
+
+void tst_Bench_DxfLib::readLines()
+{
+    long groups = 0;
+    QBENCHMARK {
+        FILE *file = fopen(demoFile, "rt");
+        QVERIFY(file);
+        DL_LineReader reader;
+        reader.setSource(file);
+        const char *code;
+        size_t codeLength;
+        const char *value;
+        size_t valueLength;
+        groups = 0;
+        while (reader.getStrippedLine(code, codeLength) &&
+               reader.getStrippedLine(value, valueLength, false)) {
+            ++groups;
+        }
+        fclose(file);
+    }
+    QVERIFY(groups > 0);
+}
+
+/*! The whole parse of demo1.dxf from a FILE, through the line reader. */
+void tst_Bench_DxfLib::parse()
+{
+    QBENCHMARK {
+        DL_Dxf dxf;
+        DL_CreationAdapter adapter;
+        QVERIFY(dxf.in(demoFile, &adapter));
+    }
+}
+
+/*! The whole parse of demo1.dxf from its memory mapping, on the calling thread. */
+void tst_Bench_DxfLib::parseMapped()
+{
+    QBENCHMARK {
+        DL_Dxf dxf;
+        DL_CreationAdapter adapter;
+        QVERIFY(dxf.inMapped(demoFile, &adapter));
+    }
+}
+
+void tst_Bench_DxfLib::toRealOld()
+{
+    double sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (const std::string &real: mReals) {
+            sum += ::toRealOld(real);
+        }
+    }
+    QVERIFY(sum == sum);
+}
+
+void tst_Bench_DxfLib::toReal()
+{
+    double sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (const std::string &real: mReals) {
+            sum += DL_Dxf::toReal(real.data(), real.length());
+        }
+    }
+    QVERIFY(sum == sum);
+}
+
+void tst_Bench_DxfLib::toIntOld()
+{
+    long sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (const std::string &code: mCodes) {
+            sum += ::toIntOld(code);
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+void tst_Bench_DxfLib::toInt()
+{
+    long sum = 0;
+    QBENCHMARK {
+        sum = 0;
+        for (const std::string &code: mCodes) {
+            sum += DL_Dxf::toInt(code.data(), code.length());
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+QTEST_APPLESS_MAIN(tst_Bench_DxfLib)
+
+#include "tst_bench_dxflib.moc"
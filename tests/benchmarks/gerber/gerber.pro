@@ -0,0 +1,12 @@
+QT = core gui testlib
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = tst_bench_gerber
+
+TEMPLATE = app
+
+include($$PWD/../../../dxf2gerber.pri)
+
+SOURCES += tst_bench_gerber.cpp
@@ -0,0 +1,200 @@
+#include <QtTest>
+#include <QBuffer>
+#include <random>
+#include "blockflattener.h"
+#include "painterpath2gerber.h"
+
+/*! @return A drawing of iInserts inserts of a block nested iDepth levels deep, each level
+ *  inserting the one below iFanOut times, rotated. The innermost block is a footprint of
+ *  lines, arcs and an ellipse. The blocks go to oBlockItems. */
+static GraphicsPrimitive getNestedDrawing(int iDepth, int iFanOut, int iInserts,
+                                          QMap<QString, GraphicsPrimitive> *oBlockItems)
+{
+    GraphicsPrimitive footprint;
+    footprint.name = "LEVEL0";
+    footprint.segments.addLine(QPointF(0, 0), QPointF(2, 0));
+    footprint.segments.addLine(QPointF(2, 0), QPointF(2, 1));
+    footprint.segments.addLine(QPointF(2, 1), QPointF(0, 1));
+    footprint.segments.addLine(QPointF(0, 1), QPointF(0, 0));
+    footprint.segments.addArc(QPointF(1, 0.5), 0.3, QPointF(1.3, 0.5), QPointF(0.7, 0.5), false);
+    footprint.segments.addArc(QPointF(1, 0.5), 0.3, QPointF(0.7, 0.5), QPointF(1.3, 0.5), false);
+    footprint.path.addEllipse(QPointF(1, 0.5), 0.8, 0.4);
+    oBlockItems->insert(footprint.name, footprint);
+    qreal pitch = 3;
+    for (int level = 1; level <= iDepth; ++level) {
+        GraphicsPrimitive block;
+        block.name = QString("LEVEL%1").arg(level);
+        for (int i = 0; i < iFanOut; ++i) {
+            GraphicsItem item;
+            item.name = QString("LEVEL%1").arg(level - 1);
+            item.pos = QPointF(i * pitch, (i % 2) * pitch);
+            item.angle = i * 90;
+            block.items.append(item);
+        }
+        oBlockItems->insert(block.name, block);
+        pitch *= iFanOut;
+    }
+    GraphicsPrimitive drawing;
+    for (int i = 0; i < iInserts; ++i) {
+        GraphicsItem item;
+        item.name = QString("LEVEL%1").arg(iDepth);
+        item.pos = QPointF(0, i * pitch);
+        drawing.items.append(item);
+    }
+    return drawing;
+}
+
+/*! How main.cpp expanded inserts at first, the path of every block again at every insert. */
+static QPainterPath getGraphicsItemPath(const GraphicsPrimitive &iItem, const QMap<QString, GraphicsPrimitive> &iBlockItems)
+{
+    QPainterPath path = iItem.path;
+    for (GraphicsItem item: iItem.items) {
+        QPainterPath itemPath = getGraphicsItemPath(iBlockItems[item.name], iBlockItems);
+        QTransform trans;
+        trans.translate(item.pos.x(), item.pos.y());
+        trans.rotate(item.angle);
+        trans.scale(item.sx, item.sy);
+        path.addPath(trans.map(itemPath));
+    }
+    return path;
+}
+
+/*! How inserts were expanded before BlockFlattener, every nested block again at every insert. */
+static void addFlattenedPrimitive(GraphicsPrimitive &ioPrimitive, const GraphicsPrimitive &iItem,
+                                  const QMap<QString, GraphicsPrimitive> &iBlockItems, const QTransform &iTrans)
+{
+    BlockFlattener::addMappedPrimitive(ioPrimitive, iItem, iTrans);
+    for (const GraphicsItem &insert: iItem.items) {
+        for (const GraphicsItem &item: BlockFlattener::getArrayItems(insert)) {
+            addFlattenedPrimitive(ioPrimitive, iBlockItems[item.name], iBlockItems,
+                                  BlockFlattener::getItemTransform(item) * iTrans);
+        }
+    }
+}
+
+/*! How getNumberStr() formatted before formatCoordinate(), through QString and two regexes. */
+static QString getNumberStrOld(PainterPath2Gerber &ioGerber, qreal iNumber)
+{
+    qreal number = iNumber / 25.4;
+    QStringList numberStr = ioGerber.doubleToStr(number, 4).split(".");
+    QString numberIntStr = ioGerber.prependZeroByDecimals(numberStr.first(), 3);
+    if (numberStr.count() == 2) {
+        numberIntStr += numberStr.last();
+    }
+    return numberIntStr;
+}
+
+class tst_Bench_Gerber : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void flattenPathOld();
+    void flattenRecursive();
+    void flattenMemoized();
+    void numberStrOld();
+    void numberStr();
+    void writeGerber();
+
+private:
+    /*! 4 levels, 8 inserts each and 5 top-level inserts: 20k footprints. */
+    GraphicsPrimitive mDrawing;
+    QMap<QString, GraphicsPrimitive> mBlockItems;
+    /*! Sizes of the flattened drawing. */
+    int mSegments = 0;
+    int mPathElements = 0;
+    /*! 100k coordinates within 500 mm of the origin. */
+    QVector<qreal> mNumbers;
+};
+
+void tst_Bench_Gerber::initTestCase()
+{
+    mDrawing = getNestedDrawing(4, 8, 5, &mBlockItems);
+    GraphicsPrimitive primitive;
+    addFlattenedPrimitive(primitive, mDrawing, mBlockItems, QTransform());
+    mSegments = primitive.segments.count();
+    mPathElements = primitive.path.elementCount();
+    QCOMPARE(mSegments, 5 * 8 * 8 * 8 * 8 * 6);
+    std::mt19937 random(23);
+    std::uniform_real_distribution<qreal> distribution(-500, 500);
+    for (int i = 0; i < 100000; ++i) {
+        mNumbers.append(distribution(random));
+    }
+}
+
+void tst_Bench_Gerber::flattenPathOld()
+{
+    QPainterPath path;
+    QBENCHMARK {
+        path = getGraphicsItemPath(mDrawing, mBlockItems);
+    }
+    QCOMPARE(path.elementCount(), mPathElements);
+}
+
+void tst_Bench_Gerber::flattenRecursive()
+{
+    GraphicsPrimitive primitive;
+    QBENCHMARK {
+        primitive = GraphicsPrimitive();
+        addFlattenedPrimitive(primitive, mDrawing, mBlockItems, QTransform());
+    }
+    QCOMPARE(primitive.segments.count(), mSegments);
+}
+
+/*! Every block flattened once, the memo is rebuilt in every iteration. */
+void tst_Bench_Gerber::flattenMemoized()
+{
+    GraphicsPrimitive primitive;
+    QBENCHMARK {
+        BlockFlattener flattener(mBlockItems);
+        primitive = flattener.getFlattenedPrimitive(mDrawing);
+    }
+    QCOMPARE(primitive.segments.count(), mSegments);
+    QCOMPARE(primitive.path.elementCount(), mPathElements);
+}
+
+void tst_Bench_Gerber::numberStrOld()
+{
+    PainterPath2Gerber gerber;
+    int length = 0;
+    QBENCHMARK {
+        length = 0;
+        for (qreal number: mNumbers) {
+            length += getNumberStrOld(gerber, number).length();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+void tst_Bench_Gerber::numberStr()
+{
+    PainterPath2Gerber gerber;
+    int length = 0;
+    QBENCHMARK {
+        length = 0;
+        for (qreal number: mNumbers) {
+            length += gerber.getNumberStr(number).length();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+/*! The whole Gerber output of the flattened drawing, its coordinates formatted into the buffer. */
+void tst_Bench_Gerber::writeGerber()
+{
+    BlockFlattener flattener(mBlockItems);
+    GraphicsPrimitive primitive = flattener.getFlattenedPrimitive(mDrawing);
+    QByteArray gerber;
+    QBENCHMARK {
+        gerber.clear();
+        QBuffer buffer(&gerber);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(PainterPath2Gerber().writeGerber(primitive, QMap<QString, GraphicsPrimitive>(), &buffer));
+    }
+    QVERIFY(gerber.size() > mSegments);
+}
+
+QTEST_GUILESS_MAIN(tst_Bench_Gerber)
+
+#include "tst_bench_gerber.moc"
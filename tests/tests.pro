@@ -0,0 +1,4 @@
+TEMPLATE = subdirs
+
+# auto: unit tests, run by "make check". benchmarks: built, but run by hand.
+SUBDIRS = auto benchmarks
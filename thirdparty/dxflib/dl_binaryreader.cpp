@@ -0,0 +1,540 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#include "dl_binaryreader.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+const char sentinel[] = "AutoCAD Binary DXF\r\n\x1a";
+// The sentinel includes its terminating '\0':
+const size_t sentinelSize = sizeof(sentinel);
+
+const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+uint64_t readLittleEndian(const char* data, size_t size) {
+    uint64_t ret = 0;
+    for (size_t i=size; i>0; --i) {
+        ret = (ret<<8) | (unsigned char)data[i-1];
+    }
+    return ret;
+}
+
+/**
+ * @return a*b rounded to the nearest integer. The rounding error of
+ * the product is recovered exactly (Dekker), so the result is correct
+ * even if a*b needs more than 53 bits.
+ */
+uint64_t roundedProduct(double a, double b) {
+    double product = a * b;
+#ifdef FP_FAST_FMA
+    double error = fma(a, b, -product);
+#else
+    const double splitter = 134217729.0; // 2^27 + 1
+    double t = splitter * a;
+    double aHigh = t - (t - a);
+    double aLow = a - aHigh;
+    t = splitter * b;
+    double bHigh = t - (t - b);
+    double bLow = b - bHigh;
+    double error = ((aHigh*bHigh - product) + aHigh*bLow + aLow*bHigh) + aLow*bLow;
+#endif
+    double integral = floor(product);
+    double fraction = (product - integral) + error;
+    return (uint64_t)integral + (int64_t)floor(fraction + 0.5);
+}
+
+size_t formatInt(long long value, char* buffer) {
+    char digits[24];
+    size_t count = 0;
+    unsigned long long v = value<0 ? 0ULL-(unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[count++] = (char)('0' + v%10);
+        v /= 10;
+    } while (v>0);
+
+    size_t length = 0;
+    if (value<0) {
+        buffer[length++] = '-';
+    }
+    while (count>0) {
+        buffer[length++] = digits[--count];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+
+/**
+ * Writes digits * 10^-decimals, without trailing zeros.
+ */
+size_t formatDecimal(bool negative, uint64_t digits, int decimals, char* buffer) {
+    while (decimals>0 && digits%10==0) {
+        digits /= 10;
+        decimals--;
+    }
+
+    char text[24];
+    size_t count = formatInt((long long)digits, text);
+
+    size_t length = 0;
+    if (negative) {
+        buffer[length++] = '-';
+    }
+    if ((int)count>decimals) {
+        size_t integral = count - decimals;
+        memcpy(buffer+length, text, integral);
+        length += integral;
+        if (decimals>0) {
+            buffer[length++] = '.';
+            memcpy(buffer+length, text+integral, decimals);
+            length += decimals;
+        }
+    } else {
+        buffer[length++] = '0';
+        buffer[length++] = '.';
+        for (int i=(int)count; i<decimals; ++i) {
+            buffer[length++] = '0';
+        }
+        memcpy(buffer+length, text, count);
+        length += count;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+}
+
+
+
+/**
+ * Default constructor.
+ */
+DL_BinaryReader::DL_BinaryReader() :
+    dataStart(NULL),
+    cursor(NULL),
+    dataEnd(NULL),
+    shortCodes(false),
+    realValue(false),
+    real(0.0) {
+}
+
+
+
+/**
+ * @return true if \p data starts with the binary DXF sentinel.
+ */
+bool DL_BinaryReader::isBinary(const char* data, size_t size) {
+    return data!=NULL && size>=sentinelSize &&
+           memcmp(data, sentinel, sentinelSize)==0;
+}
+
+
+
+/**
+ * Reads groups from the given block of memory which must start with
+ * the binary DXF sentinel. The memory is not copied and must stay
+ * valid while groups are read.
+ */
+void DL_BinaryReader::setSource(const char* data, size_t size) {
+    clear();
+    if (!isBinary(data, size)) {
+        return;
+    }
+
+    dataStart = data;
+    cursor = data + sentinelSize;
+    dataEnd = data + size;
+
+    // The first group is "0 SECTION". With 2 byte group codes the
+    // second byte is the high byte of the code 0, with 1 byte codes
+    // it is the first character of the value:
+    shortCodes = (dataEnd-cursor>=2 && cursor[1]!=0);
+}
+
+
+
+/**
+ * Detaches the reader from its data.
+ */
+void DL_BinaryReader::clear() {
+    dataStart = NULL;
+    cursor = NULL;
+    dataEnd = NULL;
+    shortCodes = false;
+    realValue = false;
+    real = 0.0;
+}
+
+
+
+/**
+ * Skips all groups up to the next group with code 0 and the given
+ * value (e.g. "ENDSEC"). Values are not decoded, only their sizes are
+ * looked at.
+ *
+ * @return Number of bytes skipped. The next group read is the group
+ *      found or, if there is none, the reader is at its end.
+ */
+size_t DL_BinaryReader::skipToGroup(const char* value) {
+    const char* start = cursor;
+    size_t valueLength = strlen(value);
+
+    while (cursor<dataEnd) {
+        const char* group = cursor;
+        unsigned int code;
+        if (!readCode(code)) {
+            break;
+        }
+
+        size_t valueSize = 0;
+        switch (getValueType(code)) {
+        case StringValue: {
+                const char* end = (const char*)memchr(cursor, '\0', dataEnd-cursor);
+                if (end==NULL) {
+                    cursor = dataEnd;
+                    return cursor - start;
+                }
+                if (code==0 && (size_t)(end-cursor)==valueLength &&
+                        memcmp(cursor, value, valueLength)==0) {
+                    cursor = group;
+                    return cursor - start;
+                }
+                valueSize = end + 1 - cursor;
+                break;
+            }
+        case RealValue:
+        case Int64Value:
+            valueSize = 8;
+            break;
+        case Int32Value:
+            valueSize = 4;
+            break;
+        case Int16Value:
+            valueSize = 2;
+            break;
+        case BoolValue:
+            valueSize = 1;
+            break;
+        case BinaryValue:
+            valueSize = cursor<dataEnd ? 1 + (unsigned char)*cursor : 1;
+            break;
+        }
+
+        if ((size_t)(dataEnd-cursor)<valueSize) {
+            cursor = dataEnd;
+            break;
+        }
+        cursor += valueSize;
+    }
+    return cursor - start;
+}
+
+
+
+/**
+ * Reads the group code at the cursor.
+ *
+ * @return false if the data ends within the group code.
+ */
+bool DL_BinaryReader::readCode(unsigned int& code) {
+    size_t codeSize = 2;
+    if (shortCodes) {
+        codeSize = (cursor<dataEnd && (unsigned char)*cursor==255) ? 3 : 1;
+    }
+    if ((size_t)(dataEnd-cursor)<codeSize) {
+        cursor = dataEnd;
+        return false;
+    }
+    if (codeSize==3) {
+        code = (unsigned int)readLittleEndian(cursor+1, 2);
+    } else {
+        code = (unsigned int)readLittleEndian(cursor, codeSize);
+    }
+    cursor += codeSize;
+    return true;
+}
+
+
+
+/**
+ * Reads the next group.
+ *
+ * @param code Group code of the group.
+ * @param value Value of the group in the form used by ASCII DXF.
+ *
+ * @retval true If a complete group was read.
+ * @retval false If the data ends in the middle of a group. The reader
+ *      is at its end afterwards.
+ */
+bool DL_BinaryReader::readGroup(unsigned int& code, std::string& value) {
+    realValue = false;
+
+    if (!readCode(code)) {
+        return false;
+    }
+
+    // Value:
+    ValueType type = getValueType(code);
+    size_t valueSize = 0;
+    switch (type) {
+    case StringValue: {
+            const char* end = (const char*)memchr(cursor, '\0', dataEnd-cursor);
+            if (end==NULL) {
+                cursor = dataEnd;
+                return false;
+            }
+            value.assign(cursor, end-cursor);
+            cursor = end + 1;
+            return true;
+        }
+    case RealValue:
+        valueSize = 8;
+        break;
+    case Int16Value:
+        valueSize = 2;
+        break;
+    case Int32Value:
+        valueSize = 4;
+        break;
+    case Int64Value:
+        valueSize = 8;
+        break;
+    case BoolValue:
+        valueSize = 1;
+        break;
+    case BinaryValue:
+        if (cursor>=dataEnd) {
+            return false;
+        }
+        valueSize = (unsigned char)*cursor++;
+        break;
+    }
+
+    if ((size_t)(dataEnd-cursor)<valueSize) {
+        cursor = dataEnd;
+        return false;
+    }
+
+    char buffer[32];
+    size_t length = 0;
+    uint64_t bits = readLittleEndian(cursor, type==BinaryValue ? 0 : valueSize);
+
+    switch (type) {
+    case RealValue:
+        memcpy(&real, &bits, sizeof(real));
+        realValue = true;
+        length = formatReal(real, buffer);
+        value.assign(buffer, length);
+        break;
+    case Int16Value:
+        length = formatInt((int16_t)bits, buffer);
+        value.assign(buffer, length);
+        break;
+    case Int32Value:
+        length = formatInt((int32_t)bits, buffer);
+        value.assign(buffer, length);
+        break;
+    case Int64Value:
+        length = formatInt((long long)(int64_t)bits, buffer);
+        value.assign(buffer, length);
+        break;
+    case BoolValue:
+        value.assign(1, bits!=0 ? '1' : '0');
+        break;
+    case BinaryValue: {
+            // binary chunks are written as hex digits in ASCII DXF:
+            static const char hex[] = "0123456789ABCDEF";
+            value.resize(2*valueSize);
+            for (size_t i=0; i<valueSize; ++i) {
+                unsigned char c = (unsigned char)cursor[i];
+                value[2*i] = hex[c>>4];
+                value[2*i+1] = hex[c&0x0f];
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    cursor += valueSize;
+    return true;
+}
+
+
+
+/**
+ * Writes \p value as decimal number that converts back to exactly the
+ * same double, like printf("%.17g") but without going through the C
+ * library for the usual range of coordinates. Values with up to 15
+ * significant digits get their shortest form, e.g. 0.1 is written as
+ * "0.1". The result does not depend on the locale.
+ *
+ * @param buffer Output, at least 32 characters.
+ * @return Number of characters written, not counting the '\\0'.
+ */
+size_t DL_BinaryReader::formatReal(double value, char* buffer) {
+    double a = fabs(value);
+
+    // Integral values:
+    if (a<1e15 && a==floor(a)) {
+        if (value==0.0) {
+            strcpy(buffer, signbit(value) ? "-0" : "0");
+            return strlen(buffer);
+        }
+        return formatInt((long long)value, buffer);
+    }
+
+    if (a>=1e-6 && a<1e15) {
+        // Decimal exponent, from the binary one. Too small by one at most:
+        int binaryExponent;
+        frexp(a, &binaryExponent);
+        int exponent = (int)floor((binaryExponent-1) * 0.30102999566398120);
+        if (exponent>=0 ? a>=powersOfTen[exponent+1]
+                        : a*powersOfTen[-exponent-1]>=1.0) {
+            exponent++;
+        }
+
+        // 15 significant digits. They are only used if dividing them by
+        // the power of ten, which is exact for both operands and
+        // correctly rounded, gives back the value:
+        int decimals = 14 - exponent;
+        if (decimals>=0 && decimals<=22) {
+            double mantissa = floor(a * powersOfTen[decimals] + 0.5);
+            if (mantissa/powersOfTen[decimals]==a) {
+                return formatDecimal(value<0, (uint64_t)mantissa, decimals, buffer);
+            }
+        }
+
+        // 17 significant digits, correctly rounded from the exact
+        // product, are always enough:
+        decimals = 16 - exponent;
+        if (decimals>=0 && decimals<22) {
+            uint64_t digits = roundedProduct(a, powersOfTen[decimals]);
+            if (digits<10000000000000000ULL) {
+                // the exponent estimate was too large:
+                decimals++;
+                digits = roundedProduct(a, powersOfTen[decimals]);
+            }
+            return formatDecimal(value<0, digits, decimals, buffer);
+        }
+    }
+
+    int length = snprintf(buffer, 32, "%.17g", value);
+    if (length<0) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    // the decimal separator comes from the locale:
+    for (int i=0; i<length; ++i) {
+        char c = buffer[i];
+        if (!((c>='0' && c<='9') || c=='-' || c=='+' || (c>='a' && c<='z'))) {
+            buffer[i] = '.';
+        }
+    }
+    return (size_t)length;
+}
+
+
+
+/**
+ * @return Encoding of the value of a group with the given code in
+ * binary DXF.
+ */
+DL_BinaryReader::ValueType DL_BinaryReader::getValueType(unsigned int code) {
+    if (code<10) {
+        return StringValue;
+    } else if (code<60) {
+        return RealValue;
+    } else if (code<80) {
+        return Int16Value;
+    } else if (code<90) {
+        return StringValue;
+    } else if (code<100) {
+        return Int32Value;
+    } else if (code<110) {
+        return StringValue;
+    } else if (code<150) {
+        return RealValue;
+    } else if (code<160) {
+        return StringValue;
+    } else if (code<170) {
+        return Int64Value;
+    } else if (code<180) {
+        return Int16Value;
+    } else if (code<210) {
+        return StringValue;
+    } else if (code<240) {
+        return RealValue;
+    } else if (code<270) {
+        return StringValue;
+    } else if (code<290) {
+        return Int16Value;
+    } else if (code<300) {
+        return BoolValue;
+    } else if (code<310) {
+        return StringValue;
+    } else if (code<320) {
+        return BinaryValue;
+    } else if (code<370) {
+        return StringValue;
+    } else if (code<390) {
+        return Int16Value;
+    } else if (code<400) {
+        return StringValue;
+    } else if (code<410) {
+        return Int16Value;
+    } else if (code<420) {
+        return StringValue;
+    } else if (code<430) {
+        return Int32Value;
+    } else if (code<440) {
+        return StringValue;
+    } else if (code<460) {
+        return Int32Value;
+    } else if (code<470) {
+        return RealValue;
+    } else if (code<1000) {
+        return StringValue;
+    } else if (code==1004) {
+        return BinaryValue;
+    } else if (code<1010) {
+        return StringValue;
+    } else if (code<1060) {
+        return RealValue;
+    } else if (code<1071) {
+        return Int16Value;
+    } else if (code==1071) {
+        return Int32Value;
+    }
+    return StringValue;
+}
+
+// EOF
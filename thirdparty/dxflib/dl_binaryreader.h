@@ -0,0 +1,106 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_BINARYREADER_H
+#define DL_BINARYREADER_H
+
+#include "dl_global.h"
+
+#include <stddef.h>
+#include <string>
+
+/**
+ * Decoder for binary DXF files.
+ *
+ * A binary DXF file starts with the sentinel
+ * "AutoCAD Binary DXF\r\n\x1a\0" followed by the groups. Every group
+ * consists of a little endian group code (2 bytes, or 1 byte in files
+ * written by R12 and older) and a value whose encoding depends on the
+ * group code: '\\0' terminated strings, 8 byte doubles, 2, 4 or 8 byte
+ * integers, 1 byte booleans or length prefixed binary chunks.
+ *
+ * Values are returned in the same text form DL_Dxf gets from ASCII
+ * files, so both formats produce the same creation interface calls.
+ * For doubles the decoded value is kept as well (see hasReal()) so the
+ * parser does not need to convert the text back to a number.
+ */
+class DXFLIB_EXPORT DL_BinaryReader {
+public:
+    DL_BinaryReader();
+
+    static bool isBinary(const char* data, size_t size);
+
+    void setSource(const char* data, size_t size);
+    void clear();
+
+    bool readGroup(unsigned int& code, std::string& value);
+    size_t skipToGroup(const char* value);
+
+    /** @return true if all groups have been read. */
+    bool atEnd() const {
+        return cursor>=dataEnd;
+    }
+
+    /** @return Number of bytes read so far, including the sentinel. */
+    size_t position() const {
+        return cursor - dataStart;
+    }
+
+    /** @return true if the value of the last group is a double. */
+    bool hasReal() const {
+        return realValue;
+    }
+
+    /** @return Value of the last group if hasReal() is true. */
+    double getReal() const {
+        return real;
+    }
+
+    static size_t formatReal(double value, char* buffer);
+
+private:
+    enum ValueType {
+        StringValue,
+        RealValue,
+        Int16Value,
+        Int32Value,
+        Int64Value,
+        BoolValue,
+        BinaryValue
+    };
+
+    static ValueType getValueType(unsigned int code);
+    bool readCode(unsigned int& code);
+
+    const char* dataStart;
+    const char* cursor;
+    const char* dataEnd;
+    // Files written by R12 and older use 1 byte group codes:
+    bool shortCodes;
+    bool realValue;
+    double real;
+};
+
+#endif
+
+// EOF
@@ -33,6 +33,7 @@
 #include "dl_codes.h"
 #include "dl_entities.h"
 #include "dl_extrusion.h"
+#include "dl_hatchboundary.h"
 
 /**
  * Abstract class (interface) for the creation of new entities.
@@ -119,6 +120,18 @@ public:
 
     /** Called for every polyline vertex */
     virtual void addVertex(const DL_VertexData& data) = 0;
+
+    /**
+     * Called with all vertices of a light weight polyline at once,
+     * between addPolyline() and endEntity(). \p data is only valid
+     * during the call. The default implementation calls addVertex()
+     * for every vertex.
+     */
+    virtual void addVertices(const DL_VertexData* data, int count) {
+        for (int i=0; i<count; ++i) {
+            addVertex(data[i]);
+        }
+    }
     
     /** Called for every spline */
     virtual void addSpline(const DL_SplineData& data) = 0;
@@ -240,6 +253,22 @@ public:
      */
     virtual void addHatchEdge(const DL_HatchEdgeData& data) = 0;
 
+    /**
+     * Called with all loops and edges of a hatch at once, after
+     * addHatch(). \p boundary is only valid during the call. The
+     * default implementation calls addHatchLoop() and addHatchEdge()
+     * for every loop and edge.
+     */
+    virtual void addHatchBoundary(const DL_HatchBoundary& boundary) {
+        for (size_t i=0; i<boundary.getLoopCount(); ++i) {
+            DL_Span<DL_HatchBoundary::Edge> edges = boundary.getEdges(i);
+            addHatchLoop(DL_HatchLoopData(edges.size));
+            for (size_t k=0; k<edges.size; ++k) {
+                addHatchEdge(boundary.getEdgeData(edges[k]));
+            }
+        }
+    }
+
     /**
      * Called for every XRecord with the given handle.
      */
@@ -341,7 +370,7 @@ public:
     virtual void endSequence() = 0;
 
     /** Sets the current attributes for entities. */
-    void setAttributes(const DL_Attributes& attrib) {
+    virtual void setAttributes(const DL_Attributes& attrib) {
         attributes = attrib;
     }
 
@@ -351,7 +380,7 @@ public:
     }
 
     /** Sets the current attributes for entities. */
-    void setExtrusion(double dx, double dy, double dz, double elevation) {
+    virtual void setExtrusion(double dx, double dy, double dz, double elevation) {
         extrusion->setDirection(dx, dy, dz);
         extrusion->setElevation(elevation);
     }
@@ -25,15 +25,29 @@
 #include "dl_dxf.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
 #include <cmath>
+#include <clocale>
+#include <locale>
+#include <mutex>
+#include <thread>
 #include <qdebug.h>
 
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
 #include "dl_attributes.h"
 #include "dl_codes.h"
 #include "dl_creationadapter.h"
+#include "dl_entitybuffer.h"
+#include "dl_mappedfile.h"
 #include "dl_writer_ascii.h"
 
 #include "iostream"
@@ -44,28 +58,16 @@
 DL_Dxf::DL_Dxf() {
     version = DL_VERSION_2000;
 
-    vertices = NULL;
     maxVertices = 0;
     vertexIndex = 0;
 
-    knots = NULL;
     maxKnots = 0;
     knotIndex = 0;
 
-    weights = NULL;
     weightIndex = 0;
 
-    controlPoints = NULL;
     maxControlPoints = 0;
     controlPointIndex = 0;
-
-    fitPoints = NULL;
-    maxFitPoints = 0;
-    fitPointIndex = 0;
-
-    leaderVertices = NULL;
-    maxLeaderVertices = 0;
-    leaderVertexIndex = 0;
 }
 
 
@@ -74,24 +76,6 @@ DL_Dxf::DL_Dxf() {
  * Destructor.
  */
 DL_Dxf::~DL_Dxf() {
-    if (vertices!=NULL) {
-        delete[] vertices;
-    }
-    if (knots!=NULL) {
-        delete[] knots;
-    }
-    if (controlPoints!=NULL) {
-        delete[] controlPoints;
-    }
-    if (fitPoints!=NULL) {
-        delete[] fitPoints;
-    }
-    if (weights!=NULL) {
-        delete[] weights;
-    }
-    if (leaderVertices!=NULL) {
-        delete[] leaderVertices;
-    }
 }
 
 
@@ -111,15 +95,38 @@ DL_Dxf::~DL_Dxf() {
 bool DL_Dxf::in(const std::string& file, DL_CreationInterface* creationInterface) {
     FILE *fp;
     firstCall = true;
-    currentObjectType = DL_UNKNOWN;
+    setObjectType(DL_UNKNOWN);
+    skippedBytes = 0;
+    resetFilterState();
+
+    // binary DXF is decoded from memory, compressed files are
+    // decompressed from their mapping:
+    size_t fileSize = 0;
+    fp = fopen(file.c_str(), "rb");
+    if (fp) {
+        char head[32];
+        size_t count = fread(head, 1, sizeof(head), fp);
+        if (fseek(fp, 0, SEEK_END)==0) {
+            long end = ftell(fp);
+            fileSize = end>0 ? (size_t)end : 0;
+        }
+        fclose(fp);
+        if (DL_BinaryReader::isBinary(head, count) ||
+            DL_DecompressingSource::getFormat(head, count)!=DL_DecompressingSource::NoCompression) {
+            return inMapped(file, creationInterface);
+        }
+    }
 
     fp = fopen(file.c_str(), "rt");
     if (fp) {
-        std::locale oldLocale = std::locale::global(std::locale("C"));	// use dot in numbers
-        while (readDxfGroups(fp, creationInterface)) {}
-        std::locale::global(oldLocale);
+        // numbers are parsed independent of the locale, see toReal():
+        lineReader.setSource(fp);
+        startProgress(fileSize);
+        while (readDxfGroups(creationInterface)) {}
+        bool complete = finishProgress(lineReader.position());
+        lineReader.clear();
         fclose(fp);
-        return true;
+        return complete;
     }
 
     return false;
@@ -135,22 +142,652 @@ bool DL_Dxf::in(const std::string& file, DL_CreationInterface* creationInterface
  *      Pointer to the class which takes care of the entities in the file.
  *
  * @retval true If \p file could be opened.
- * @retval false If \p file could not be opened.
+ * @retval false If \p file could not be opened or reading was canceled.
  */
 bool DL_Dxf::in(std::stringstream& stream,
                 DL_CreationInterface* creationInterface) {
     
     if (stream.good()) {
+        // binary and compressed DXF is decoded from memory:
+        std::streampos start = stream.tellg();
+        char head[32];
+        stream.read(head, sizeof(head));
+        size_t count = (size_t)stream.gcount();
+        stream.clear();
+        stream.seekg(start);
+        if (DL_BinaryReader::isBinary(head, count) ||
+            DL_DecompressingSource::getFormat(head, count)!=DL_DecompressingSource::NoCompression) {
+            std::string contents = stream.str().substr((size_t)start);
+            stream.seekg(0, std::ios::end);
+            return in(contents.data(), contents.size(), creationInterface);
+        }
+
         firstCall=true;
-        currentObjectType = DL_UNKNOWN;
-        while (readDxfGroups(stream, creationInterface)) {}
+        setObjectType(DL_UNKNOWN);
+        skippedBytes = 0;
+        resetFilterState();
+        lineReader.setSource(stream);
+        startProgress(0);
+        while (readDxfGroups(creationInterface)) {}
+        bool complete = finishProgress(lineReader.position());
+        lineReader.clear();
+        return complete;
+    }
+    return false;
+}
+
+
+
+/**
+ * @brief Reads a DXF file from a block of memory.
+ *
+ * The group codes and values are tokenized directly from \p data,
+ * no copy of the buffer is made. \p data must stay valid until
+ * this function returns. Binary DXF is detected by its sentinel
+ * and decoded with DL_BinaryReader. gzip and zstd compressed data is
+ * detected by its magic bytes and decompressed while it is read, see
+ * \p in(DL_InputSource&, ...).
+ *
+ * @param data Pointer to the first byte of the DXF contents.
+ * @param size Number of bytes in \p data.
+ * @param creationInterface
+ *      Pointer to the class which takes care of the entities in the file.
+ *
+ * @retval true If \p data is not NULL.
+ * @retval false If \p data is NULL, compressed data cannot be
+ *      decompressed or reading was canceled.
+ */
+bool DL_Dxf::in(const char* data, size_t size,
+                DL_CreationInterface* creationInterface) {
+
+    if (data==NULL && size>0) {
+        return false;
+    }
+
+    if (DL_DecompressingSource::getFormat(data, size)!=DL_DecompressingSource::NoCompression) {
+        DL_DecompressingSource source;
+        if (!source.open(data, size)) {
+            return false;
+        }
+        return in(source, creationInterface);
+    }
+
+    firstCall = true;
+    setObjectType(DL_UNKNOWN);
+    skippedBytes = 0;
+    resetFilterState();
+
+    // the whole file is at hand, so unused blocks can be found up front:
+    if (!layerFilter.empty()) {
+        findRequiredBlocks(data, size);
+    }
+
+    startProgress(size);
+
+    if (DL_BinaryReader::isBinary(data, size)) {
+        binaryInput = true;
+        binaryReader.setSource(data, size);
+        while (readDxfGroups(creationInterface)) {}
+        bool complete = finishProgress(binaryReader.position());
+        binaryReader.clear();
+        binaryInput = false;
+        resetFilterState();
+        return complete;
+    }
+
+    lineReader.setSource(data, size);
+    bool sectionStart = false;
+    while (readDxfGroups(creationInterface)) {
+        if (sectionStart && entityThreads>1 &&
+            groupCode==2 && groupValue=="ENTITIES") {
+            readEntitiesParallel(data, size, creationInterface);
+        }
+        sectionStart = (groupCode==0 && groupValue=="SECTION");
+    }
+    bool complete = finishProgress(lineReader.position());
+    lineReader.clear();
+    resetFilterState();
+    return complete;
+}
+
+
+
+/**
+ * @brief Parses the ENTITIES section on \p entityThreads worker threads.
+ *
+ * Called by \p in(const char*, ...) right after the "2 ENTITIES" group
+ * was read. The section is split at entity boundaries (group code 0)
+ * into chunks. Every chunk is parsed by its own parser into a
+ * DL_EntityBuffer. The buffers are replayed to \p creationInterface
+ * in file order while the workers continue, so the application sees
+ * the same calls in the same order as for a serial parse, on the
+ * calling thread.
+ *
+ * processCodeValuePair() is not called for the groups of the section.
+ *
+ * @retval true If the section was parsed and the line reader points
+ *      behind its ENDSEC group.
+ * @retval false If the section is too small to be worth splitting or
+ *      has no ENDSEC. Nothing has been read in that case.
+ */
+bool DL_Dxf::readEntitiesParallel(const char* data, size_t size,
+                                  DL_CreationInterface* creationInterface) {
+
+    const size_t minChunkSize = 64*1024;
+
+    // Find the start and end offset of every group with code 0 up to and
+    // including the ENDSEC of the section:
+    struct Boundary {
+        size_t begin;
+        size_t end;
+        bool split;
+    };
+    std::vector<Boundary> boundaries;
+    bool sectionEnd = false;
+    {
+        DL_LineReader scanner;
+        scanner.setSource(data, size);
+        scanner.seek(lineReader.position());
+
+        const char* line;
+        size_t length;
+        while (!sectionEnd) {
+            size_t begin = scanner.position();
+            if (!scanner.getStrippedLine(line, length)) {
+                break;
+            }
+            bool entityStart = (toInt(line, length)==0);
+            if (!scanner.getStrippedLine(line, length, false)) {
+                break;
+            }
+            if (entityStart) {
+                std::string type(line, length);
+                Boundary b;
+                b.begin = begin;
+                b.end = scanner.position();
+                // vertices and attributes stay with their POLYLINE or
+                // INSERT, a chunk never starts with them:
+                b.split = (type!="VERTEX" && type!="ATTRIB" && type!="SEQEND");
+                boundaries.push_back(b);
+                sectionEnd = (type=="ENDSEC");
+            }
+        }
+    }
+
+    if (!sectionEnd || boundaries.size()<3) {
+        return false;
+    }
+
+    size_t sectionSize = boundaries.back().end - boundaries.front().begin;
+    size_t chunkSize = std::max(sectionSize/(entityThreads*8), minChunkSize);
+    if (sectionSize<2*minChunkSize) {
+        return false;
+    }
+
+    // Anything in front of the first entity and the start of the first
+    // entity are read by this parser as usual:
+    while (lineReader.position()<boundaries.front().end) {
+        readDxfGroups(creationInterface);
+    }
+
+    // Every chunk starts at an entity boundary and includes the boundary
+    // group of the next chunk, which completes its last entity:
+    std::vector<std::pair<size_t, size_t> > ranges;
+    // Number of groups with code 0 the chunk reports:
+    std::vector<size_t> rangeEntities;
+    size_t first = 0;
+    for (size_t i=1; i<boundaries.size(); ++i) {
+        bool last = (i==boundaries.size()-1);
+        if (last || (boundaries[i].split &&
+                     boundaries[i].begin-boundaries[first].begin>=chunkSize)) {
+            ranges.push_back(std::make_pair(boundaries[first].begin, boundaries[i].end));
+            rangeEntities.push_back(i - first);
+            first = i;
+        }
+    }
+
+    // Creation interfaces cannot be copied, the buffers are created in place:
+    struct Chunk {
+        Chunk() : begin(0), end(0), entities(0), done(false) {}
+        size_t begin;
+        size_t end;
+        size_t entities;
+        bool done;
+        DL_EntityBuffer buffer;
+    };
+    std::vector<Chunk> chunks(ranges.size());
+    for (size_t i=0; i<ranges.size(); ++i) {
+        chunks[i].begin = ranges[i].first;
+        chunks[i].end = ranges[i].second;
+        chunks[i].entities = rangeEntities[i];
+    }
+
+    std::atomic<size_t> nextChunk(0);
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    int version = libVersion;
+
+    std::vector<std::thread> workers;
+    size_t threadCount = std::min((size_t)entityThreads, chunks.size());
+    for (size_t t=0; t<threadCount; ++t) {
+        workers.push_back(std::thread([&]() {
+            DL_Dxf parser;
+            parser.libVersion = version;
+            parser.layerFilter = layerFilter;
+            parser.cancelFlag = cancelFlag;
+            for (size_t i=nextChunk++; i<chunks.size(); i=nextChunk++) {
+                Chunk& chunk = chunks[i];
+                parser.readEntityChunk(data + chunk.begin, chunk.end - chunk.begin,
+                                       &chunk.buffer);
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk.done = true;
+                chunkDone.notify_all();
+            }
+        }));
+    }
+
+    bool stopped = false;
+    for (size_t i=0; i<chunks.size(); ++i) {
+        Chunk& chunk = chunks[i];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!chunk.done) {
+                chunkDone.wait(lock);
+            }
+        }
+        chunk.buffer.replay(creationInterface);
+        chunk.buffer.clear();
+
+        entityCount += chunk.entities;
+        if (updateProgress(chunk.end)) {
+            // the workers finish their current chunk and take no new one:
+            nextChunk = chunks.size();
+            stopped = true;
+            break;
+        }
+    }
+
+    for (size_t t=0; t<workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    if (stopped) {
+        lineReader.seek(size);
         return true;
     }
+
+    // Continue behind the ENDSEC. The workers already reported the last
+    // entity, only the parser state is brought up to date:
+    lineReader.seek(boundaries.back().end);
+    groupCode = 0;
+    groupValue = "ENDSEC";
+    creationInterface->processCodeValuePair(groupCode, groupValue);
+    DL_CreationAdapter muted;
+    setObjectType(DL_UNKNOWN);
+    processDXFGroup(&muted, groupCode, groupValue);
+
+    return true;
+}
+
+
+
+/**
+ * Reads one chunk of the ENTITIES section prepared by
+ * \p readEntitiesParallel(). The first group of the chunk only
+ * completes the last entity of the previous chunk, so its calls are
+ * dropped.
+ */
+void DL_Dxf::readEntityChunk(const char* data, size_t size,
+                             DL_CreationInterface* creationInterface) {
+    firstCall = true;
+    setObjectType(DL_UNKNOWN);
+    resetFilterState();
+
+    DL_CreationAdapter muted;
+    lineReader.setSource(data, size);
+    readDxfGroups(&muted);
+    while (readDxfGroups(creationInterface)) {}
+    lineReader.clear();
+}
+
+
+
+/**
+ * Collects the blocks which are needed for the entities on the layers
+ * of the layer filter: blocks inserted by INSERT or DIMENSION entities
+ * on these layers and, recursively, blocks inserted by those blocks.
+ * All other blocks are skipped while reading. Entities inside blocks
+ * are never filtered by their own layer since they are drawn on the
+ * layer of the insert.
+ */
+void DL_Dxf::findRequiredBlocks(const char* data, size_t size) {
+    std::set<std::string> roots;
+    std::map<std::string, std::vector<std::string> > references;
+
+    bool binary = DL_BinaryReader::isBinary(data, size);
+    DL_BinaryReader binaryScanner;
+    DL_LineReader lineScanner;
+    if (binary) {
+        binaryScanner.setSource(data, size);
+    } else {
+        lineScanner.setSource(data, size);
+    }
+
+    std::string section;
+    std::string block;
+    std::string type;
+    std::string layer;
+    std::string reference;
+    std::string value;
+
+    while (true) {
+        unsigned int code;
+        if (binary) {
+            if (binaryScanner.atEnd() || !binaryScanner.readGroup(code, value)) {
+                break;
+            }
+        } else {
+            const char* line;
+            size_t length;
+            if (!lineScanner.getStrippedLine(line, length)) {
+                break;
+            }
+            code = (unsigned int)toInt(line, length);
+            if (!lineScanner.getStrippedLine(line, length, false)) {
+                break;
+            }
+            // only the values used below are copied:
+            if (code!=0 && code!=2 && code!=8) {
+                continue;
+            }
+            value.assign(line, length);
+        }
+
+        if (code==0) {
+            if (!reference.empty()) {
+                if (!block.empty()) {
+                    references[block].push_back(reference);
+                } else if (section=="ENTITIES" &&
+                           layerFilter.find(layer)!=layerFilter.end()) {
+                    roots.insert(reference);
+                }
+            }
+            if (type=="ENDBLK") {
+                block.clear();
+            }
+            type = value;
+            layer = "0";
+            reference.clear();
+        } else if (code==2) {
+            if (type=="SECTION") {
+                section = value;
+            } else if (type=="BLOCK") {
+                block = value;
+            } else if (type=="INSERT" || type=="DIMENSION") {
+                reference = value;
+            }
+        } else if (code==8) {
+            layer = value;
+        }
+    }
+
+    requiredBlocks.clear();
+    std::vector<std::string> pending(roots.begin(), roots.end());
+    while (!pending.empty()) {
+        std::string name = pending.back();
+        pending.pop_back();
+        if (!requiredBlocks.insert(name).second) {
+            continue;
+        }
+        std::map<std::string, std::vector<std::string> >::const_iterator it =
+            references.find(name);
+        if (it!=references.end()) {
+            pending.insert(pending.end(), it->second.begin(), it->second.end());
+        }
+    }
+    filterBlocks = true;
+}
+
+
+
+/**
+ * Checks the current group against the layer filter.
+ *
+ * @retval true If the current entity is on a filtered layer or the
+ *      current block is not needed. All further groups of the entity
+ *      or block are dropped.
+ */
+bool DL_Dxf::isFiltered() {
+    if (layerFilter.empty()) {
+        return false;
+    }
+
+    if (groupCode==8 && !inBlock &&
+        currentObjectType>=DL_ENTITY_POINT && currentObjectType<=DL_ENTITY_SEQEND &&
+        currentObjectType!=DL_ENTITY_IMAGEDEF &&
+        currentObjectType!=DL_ENTITY_VERTEX &&
+        currentObjectType!=DL_ENTITY_ATTRIB &&
+        currentObjectType!=DL_ENTITY_SEQEND &&
+        layerFilter.find(groupValue)==layerFilter.end()) {
+
+        skipEntity = true;
+        skipSequence = (currentObjectType==DL_ENTITY_POLYLINE ||
+                        currentObjectType==DL_ENTITY_INSERT);
+        return true;
+    }
+
+    if (groupCode==2 && currentObjectType==DL_BLOCK && filterBlocks &&
+        requiredBlocks.find(groupValue)==requiredBlocks.end()) {
+        skipBlock = true;
+        skipEntity = true;
+        return true;
+    }
+
     return false;
 }
 
 
 
+/**
+ * Resets the state of the layer filter for a new file.
+ */
+void DL_Dxf::resetFilterState() {
+    filterBlocks = false;
+    inBlock = false;
+    skipBlock = false;
+    skipEntity = false;
+    skipSequence = false;
+    atSectionStart = false;
+    atTableStart = false;
+}
+
+
+
+/**
+ * Skips the rest of the current section or table in geometry only
+ * mode if it is not needed for geometry. Called for every group after
+ * it has been processed, the skip starts behind the name (group code 2)
+ * of the section or table and stops in front of its ENDSEC / ENDTAB.
+ */
+void DL_Dxf::skipUnusedGroups() {
+    if (groupCode==0) {
+        atSectionStart = (groupValue=="SECTION");
+        atTableStart = (groupValue=="TABLE");
+        return;
+    }
+    if (groupCode!=2) {
+        return;
+    }
+
+    const char* end = NULL;
+    if (atSectionStart) {
+        if (groupValue!="TABLES" && groupValue!="BLOCKS" &&
+            groupValue!="ENTITIES") {
+            end = "ENDSEC";
+        }
+    } else if (atTableStart) {
+        if (groupValue!="LAYER") {
+            end = "ENDTAB";
+        }
+    }
+    atSectionStart = false;
+    atTableStart = false;
+
+    if (end!=NULL) {
+        if (binaryInput) {
+            skippedBytes += binaryReader.skipToGroup(end);
+        } else {
+            skippedBytes += lineReader.skipToGroup(end);
+        }
+    }
+}
+
+
+
+/**
+ * Resets the progress for a new input of \p totalBytes bytes (0 if
+ * unknown).
+ */
+void DL_Dxf::startProgress(size_t totalBytes) {
+    progressTotal = totalBytes;
+    entityCount = 0;
+    canceled = false;
+    if (progressCallback) {
+        nextProgress = progressInterval;
+        progressStart = std::chrono::steady_clock::now();
+    }
+}
+
+
+
+/**
+ * Checks the cancel flag and calls the progress callback if the
+ * next interval has been reached. Called through pollProgress().
+ *
+ * @retval true if reading has been canceled.
+ */
+bool DL_Dxf::updateProgress(size_t position) {
+    if (cancelFlag!=NULL && cancelFlag->load(std::memory_order_relaxed)) {
+        canceled = true;
+        return true;
+    }
+
+    if (position>=nextProgress && progressCallback) {
+        reportProgress(position);
+        nextProgress = position + progressInterval;
+    }
+    return false;
+}
+
+
+
+/**
+ * Calls the progress callback for the given position.
+ */
+void DL_Dxf::reportProgress(size_t position) {
+    DL_ProgressData data;
+    data.bytes = position;
+    data.totalBytes = progressTotal;
+    data.entities = entityCount;
+    data.elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - progressStart).count();
+    progressCallback(data);
+}
+
+
+
+/**
+ * Reports the final progress at the end of the input.
+ *
+ * @retval true if the input has been read completely.
+ * @retval false if reading has been canceled.
+ */
+bool DL_Dxf::finishProgress(size_t position) {
+    if (!canceled && progressCallback) {
+        reportProgress(position);
+    }
+    return !canceled;
+}
+
+
+
+/**
+ * @brief Reads the given file through a read-only memory mapping.
+ *
+ * Unlike \p in(const std::string&, ...) the file is not read through
+ * stdio and unlike \p in(std::stringstream&, ...) the caller does not
+ * need to load it into memory first. Peak memory stays close to the
+ * file size which matters for very large drawings.
+ *
+ * @param file Input
+ *      Path and name of file to read
+ * @param creationInterface
+ *      Pointer to the class which takes care of the entities in the file.
+ *
+ * @retval true If \p file could be opened.
+ * @retval false If \p file could not be opened.
+ */
+bool DL_Dxf::inMapped(const std::string& file,
+                      DL_CreationInterface* creationInterface) {
+    DL_MappedFile mappedFile;
+    if (!mappedFile.open(file)) {
+        return false;
+    }
+
+    return in(mappedFile.data(), mappedFile.size(), creationInterface);
+}
+
+
+
+/**
+ * @brief Reads a DXF file from an input source.
+ *
+ * The source is read block by block through the buffer of the line
+ * reader, so memory use does not depend on the size of the file.
+ * This is how compressed files are read (see DL_DecompressingSource).
+ * As the file is not in memory as a whole, the ENTITIES section is
+ * parsed on the calling thread and blocks are not filtered up front.
+ * Binary DXF is an exception, it is read into memory first.
+ *
+ * @param source The source, e.g. a DL_DecompressingSource.
+ * @param creationInterface
+ *      Pointer to the class which takes care of the entities in the file.
+ *
+ * @retval true If the source could be read completely.
+ * @retval false If the source reported an error, e.g. for corrupt
+ *      compressed data, or reading was canceled. Groups read up to
+ *      that point have been passed to \p creationInterface.
+ */
+bool DL_Dxf::in(DL_InputSource& source,
+                DL_CreationInterface* creationInterface) {
+    lineReader.setSource(source);
+
+    // binary DXF is decoded from memory:
+    const char* head;
+    size_t headSize;
+    lineReader.peek(head, headSize);
+    if (DL_BinaryReader::isBinary(head, headSize)) {
+        std::string contents;
+        lineReader.readAll(contents);
+        lineReader.clear();
+        return in(contents.data(), contents.size(), creationInterface) &&
+               !source.hasError();
+    }
+
+    firstCall = true;
+    setObjectType(DL_UNKNOWN);
+    skippedBytes = 0;
+    resetFilterState();
+    startProgress(0);
+    while (readDxfGroups(creationInterface)) {}
+    bool complete = finishProgress(lineReader.position());
+    lineReader.clear();
+    resetFilterState();
+    return complete && !source.hasError();
+}
+
+
+
 /**
  * @brief Reads a group couplet from a DXF file.  Calls another function
  * to process it.
@@ -163,102 +800,91 @@ bool DL_Dxf::in(std::stringstream& stream,
  * passes the value to the the appropriate handler function of
  * \p creationInterface.\n
  * 
- * \p fp is advanced so that the next call to \p readDXFGroups() reads
- * the next couplet in the file.
+ * The input is read from the source the line reader was set up with
+ * in \p in(). The reader is advanced so that the next call to
+ * \p readDxfGroups() reads the next couplet in the file.
  *
- * @param fp Handle of input file
  * @param creationInterface Handle of class which processes entities
  *      in the file
  *
  * @retval true If EOF not reached.
- * @retval false If EOF reached.
+ * @retval false If EOF reached or reading was canceled, see
+ *      \p setCancelFlag().
  */
-bool DL_Dxf::readDxfGroups(FILE *fp, DL_CreationInterface* creationInterface) {
+bool DL_Dxf::readDxfGroups(DL_CreationInterface* creationInterface) {
 
-    static int line = 1;
+    if (binaryInput) {
+        return readBinaryDxfGroups(creationInterface);
+    }
 
-    // Read one group of the DXF file and strip the lines:
-    if (DL_Dxf::getStrippedLine(groupCodeTmp, DL_DXF_MAXLINE, fp) &&
-            DL_Dxf::getStrippedLine(groupValue, DL_DXF_MAXLINE, fp, false) ) {
+    const char* codeLine;
+    size_t codeLength;
+    const char* valueLine;
+    size_t valueLength;
 
-        groupCode = (unsigned int)toInt(groupCodeTmp);
+    // Read one group of the DXF file and strip the lines. The group code
+    // slice is only valid until the next line is read, so convert it first:
+    if (lineReader.getStrippedLine(codeLine, codeLength)) {
+        unsigned int code = (unsigned int)toInt(codeLine, codeLength);
 
-        creationInterface->processCodeValuePair(groupCode, groupValue);
-        line+=2;
-        processDXFGroup(creationInterface, groupCode, groupValue);
+        if (lineReader.getStrippedLine(valueLine, valueLength, false)) {
+            groupValue.assign(valueLine, valueLength);
+            groupCode = code;
+
+            creationInterface->processCodeValuePair(groupCode, groupValue);
+            processDXFGroup(creationInterface, groupCode, groupValue);
+            if (geometryOnly) {
+                skipUnusedGroups();
+            }
+            if (pollProgress(lineReader.position())) {
+                return false;
+            }
+        }
     }
 
-    return !feof(fp);
+    return !lineReader.atEnd();
 }
 
 
 
 /**
- * Same as above but for stringstreams.
+ * Same as above for binary DXF input. Doubles are passed on decoded,
+ * see getGroupRealValue().
  */
-bool DL_Dxf::readDxfGroups(std::stringstream& stream,
-                           DL_CreationInterface* creationInterface) {
-
-    static int line = 1;
+bool DL_Dxf::readBinaryDxfGroups(DL_CreationInterface* creationInterface) {
+    unsigned int code;
+    if (binaryReader.readGroup(code, groupValue)) {
+        groupCode = code;
+        groupHasReal = binaryReader.hasReal();
+        groupReal = binaryReader.getReal();
 
-    // Read one group of the DXF file and chop the lines:
-    if (DL_Dxf::getStrippedLine(groupCodeTmp, DL_DXF_MAXLINE, stream) &&
-            DL_Dxf::getStrippedLine(groupValue, DL_DXF_MAXLINE, stream, false) ) {
-
-        groupCode = (unsigned int)toInt(groupCodeTmp);
-
-        line+=2;
+        creationInterface->processCodeValuePair(groupCode, groupValue);
         processDXFGroup(creationInterface, groupCode, groupValue);
+        if (geometryOnly) {
+            skipUnusedGroups();
+        }
+
+        groupHasReal = false;
+        if (pollProgress(binaryReader.position())) {
+            return false;
+        }
     }
-    return !stream.eof();
+
+    return !binaryReader.atEnd();
 }
 
 
 
 /**
- * @brief Reads line from file & strips whitespace at start and newline 
- * at end.
- *
- * @param s Output\n
- *      Pointer to character array that chopped line will be returned in.
- * @param size Size of \p s.  (Including space for NULL.)
- * @param fp Input\n
- *      Handle of input file.
- *
- * @retval true if line could be read
- * @retval false if \p fp is already at end of file
- *
- * @todo Change function to use safer FreeBSD strl* functions
- * @todo Is it a problem if line is blank (i.e., newline only)?
- *      Then, when function returns, (s==NULL).
+ * Same as above but reads from the given file. Calling this function
+ * directly (without \p in()) reads from \p fp in large blocks, so its
+ * file position will be ahead of the last couplet read.
  */
-bool DL_Dxf::getStrippedLine(std::string& s, unsigned int size, FILE *fp, bool stripSpace) {
-    if (!feof(fp)) {
-        // The whole line in the file.  Includes space for NULL.
-        char* wholeLine = new char[size];
-        // Only the useful part of the line
-        char* line;
-
-        line = fgets(wholeLine, size, fp);
-
-        if (line!=NULL && line[0] != '\0') { // Evaluates to fgets() retval
-            // line == wholeLine at this point.
-            // Both guaranteed to be NULL terminated.
-
-            // Strip leading whitespace and trailing CR/LF.
-            stripWhiteSpace(&line, stripSpace);
-
-            s = line;
-            assert(size > s.length());
-        }
-
-        delete[] wholeLine; // Done with wholeLine
-
-        return true;
-    } else {
-        s = "";
-        return false;
+bool DL_Dxf::readDxfGroups(FILE *fp, DL_CreationInterface* creationInterface) {
+    if (!lineReader.hasSource(fp)) {
+        lineReader.setSource(fp);
     }
+    return readDxfGroups(creationInterface);
 }
 
 
@@ -266,23 +892,12 @@ bool DL_Dxf::getStrippedLine(std::string& s, unsigned int size, FILE *fp, bool s
 /**
  * Same as above but for stringstreams.
  */
-bool DL_Dxf::getStrippedLine(std::string &s, unsigned int size,
-                            std::stringstream& stream, bool stripSpace) {
-
-    if (!stream.eof()) {
-        // Only the useful part of the line
-        char* line = new char[size+1];
-        char* oriLine = line;
-        stream.getline(line, size);
-        stripWhiteSpace(&line, stripSpace);
-        s = line;
-        assert(size > s.length());
-        delete[] oriLine;
-        return true;
-    } else {
-        s[0] = '\0';
-        return false;
+bool DL_Dxf::readDxfGroups(std::stringstream& stream,
+                           DL_CreationInterface* creationInterface) {
+    if (!lineReader.hasSource(&stream)) {
+        lineReader.setSource(stream);
     }
+    return readDxfGroups(creationInterface);
 }
 
 
@@ -358,221 +973,225 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
 
     // Indicates start of new entity or variable:
     else if (groupCode==0 || groupCode==9) {
-        // If new entity is encountered, the last one is complete.
-        // Prepare default attributes for next entity:
-        std::string layer = getStringValue(8, "0");
-
-        int width;
-        // Compatibility with qcad1:
-        if (hasValue(39) && !hasValue(370)) {
-            width = getIntValue(39, -1);
-        }
-        // since autocad 2002:
-        else if (hasValue(370)) {
-            width = getIntValue(370, -1);
-        }
-        // default to BYLAYER:
-        else {
-            width = -1;
-        }
-
-        int color;
-        color = getIntValue(62, 256);
-        int color24;
-        color24 = getIntValue(420, -1);
-        int handle;
-        handle = getInt16Value(5, -1);
-
-        std::string linetype = getStringValue(6, "BYLAYER");
-
-        attrib = DL_Attributes(layer,                   // layer
-                               color,                   // color
-                               color24,                 // 24 bit color
-                               width,                   // width
-                               linetype,                // linetype
-                               handle);                 // handle
-        attrib.setInPaperSpace((bool)getIntValue(67, 0));
-        attrib.setLinetypeScale(getRealValue(48, 1.0));
-        creationInterface->setAttributes(attrib);
+        // Entities on filtered layers and unused blocks are not reported:
+        bool skipped = skipEntity;
+        if (!skipped) {
+            // If new entity is encountered, the last one is complete.
+            // Prepare default attributes for next entity:
+            std::string layer = getStringValue(8, "0");
+
+            int width;
+            // Compatibility with qcad1:
+            if (hasValue(39) && !hasValue(370)) {
+                width = getIntValue(39, -1);
+            }
+            // since autocad 2002:
+            else if (hasValue(370)) {
+                width = getIntValue(370, -1);
+            }
+            // default to BYLAYER:
+            else {
+                width = -1;
+            }
 
-        int elevationGroupCode=30;
-        if (currentObjectType==DL_ENTITY_LWPOLYLINE ) {
-            // see lwpolyline group codes reference
-            elevationGroupCode=38;
-        }
-        else {
-            // see polyline group codes reference
-            elevationGroupCode=30;
-        }
+            int color;
+            color = getIntValue(62, 256);
+            int color24;
+            color24 = getIntValue(420, -1);
+            int handle;
+            handle = getInt16Value(5, -1);
+
+            std::string linetype = getStringValue(6, "BYLAYER");
+
+            attrib = DL_Attributes(layer,                   // layer
+                                   color,                   // color
+                                   color24,                 // 24 bit color
+                                   width,                   // width
+                                   linetype,                // linetype
+                                   handle);                 // handle
+            attrib.setInPaperSpace((bool)getIntValue(67, 0));
+            attrib.setLinetypeScale(getRealValue(48, 1.0));
+            creationInterface->setAttributes(attrib);
+
+            int elevationGroupCode=30;
+            if (currentObjectType==DL_ENTITY_LWPOLYLINE ) {
+                // see lwpolyline group codes reference
+                elevationGroupCode=38;
+            }
+            else {
+                // see polyline group codes reference
+                elevationGroupCode=30;
+            }
 
-        creationInterface->setExtrusion(getRealValue(210, 0.0),
-                                        getRealValue(220, 0.0),
-                                        getRealValue(230, 1.0),
-                                        getRealValue(elevationGroupCode, 0.0));
+            creationInterface->setExtrusion(getRealValue(210, 0.0),
+                                            getRealValue(220, 0.0),
+                                            getRealValue(230, 1.0),
+                                            getRealValue(elevationGroupCode, 0.0));
 
-        // Add the previously parsed entity via creationInterface
-        switch (currentObjectType) {
-        case DL_SETTING:
-            addSetting(creationInterface);
-            break;
+            // Add the previously parsed entity via creationInterface
+            switch (currentObjectType) {
+            case DL_SETTING:
+                addSetting(creationInterface);
+                break;
 
-        case DL_LAYER:
-            addLayer(creationInterface);
-            break;
+            case DL_LAYER:
+                addLayer(creationInterface);
+                break;
 
-        case DL_LINETYPE:
-            addLinetype(creationInterface);
-            break;
+            case DL_LINETYPE:
+                addLinetype(creationInterface);
+                break;
 
-        case DL_BLOCK:
-            addBlock(creationInterface);
-            break;
+            case DL_BLOCK:
+                addBlock(creationInterface);
+                break;
 
-        case DL_ENDBLK:
-            endBlock(creationInterface);
-            break;
+            case DL_ENDBLK:
+                endBlock(creationInterface);
+                break;
 
-        case DL_STYLE:
-            addTextStyle(creationInterface);
-            break;
+            case DL_STYLE:
+                addTextStyle(creationInterface);
+                break;
 
-        case DL_ENTITY_POINT:
-            addPoint(creationInterface);
-            break;
+            case DL_ENTITY_POINT:
+                addPoint(creationInterface);
+                break;
 
-        case DL_ENTITY_LINE:
-            addLine(creationInterface);
-            break;
+            case DL_ENTITY_LINE:
+                addLine(creationInterface);
+                break;
 
-        case DL_ENTITY_XLINE:
-            addXLine(creationInterface);
-            break;
+            case DL_ENTITY_XLINE:
+                addXLine(creationInterface);
+                break;
 
-        case DL_ENTITY_RAY:
-            addRay(creationInterface);
-            break;
+            case DL_ENTITY_RAY:
+                addRay(creationInterface);
+                break;
 
-        case DL_ENTITY_POLYLINE:
-        case DL_ENTITY_LWPOLYLINE:
-            addPolyline(creationInterface);
-            break;
+            case DL_ENTITY_POLYLINE:
+            case DL_ENTITY_LWPOLYLINE:
+                addPolyline(creationInterface);
+                break;
 
-        case DL_ENTITY_VERTEX:
-            addVertex(creationInterface);
-            break;
+            case DL_ENTITY_VERTEX:
+                addVertex(creationInterface);
+                break;
 
-        case DL_ENTITY_SPLINE:
-            addSpline(creationInterface);
-            break;
+            case DL_ENTITY_SPLINE:
+                addSpline(creationInterface);
+                break;
 
-        case DL_ENTITY_ARC:
-            addArc(creationInterface);
-            break;
+            case DL_ENTITY_ARC:
+                addArc(creationInterface);
+                break;
 
-        case DL_ENTITY_CIRCLE:
-            addCircle(creationInterface);
-            break;
+            case DL_ENTITY_CIRCLE:
+                addCircle(creationInterface);
+                break;
 
-        case DL_ENTITY_ELLIPSE:
-            addEllipse(creationInterface);
-            break;
+            case DL_ENTITY_ELLIPSE:
+                addEllipse(creationInterface);
+                break;
 
-        case DL_ENTITY_INSERT:
-            addInsert(creationInterface);
-            break;
+            case DL_ENTITY_INSERT:
+                addInsert(creationInterface);
+                break;
 
-        case DL_ENTITY_MTEXT:
-            addMText(creationInterface);
-            break;
+            case DL_ENTITY_MTEXT:
+                addMText(creationInterface);
+                break;
 
-        case DL_ENTITY_TEXT:
-            addText(creationInterface);
-            break;
+            case DL_ENTITY_TEXT:
+                addText(creationInterface);
+                break;
 
-        case DL_ENTITY_ARCALIGNEDTEXT:
-            addArcAlignedText(creationInterface);
-            break;
+            case DL_ENTITY_ARCALIGNEDTEXT:
+                addArcAlignedText(creationInterface);
+                break;
 
-        case DL_ENTITY_ATTRIB:
-            addAttribute(creationInterface);
-            break;
+            case DL_ENTITY_ATTRIB:
+                addAttribute(creationInterface);
+                break;
 
-        case DL_ENTITY_DIMENSION: {
-                int type = (getIntValue(70, 0)&0x07);
+            case DL_ENTITY_DIMENSION: {
+                    int type = (getIntValue(70, 0)&0x07);
 
-                switch (type) {
-                case 0:
-                    addDimLinear(creationInterface);
-                    break;
+                    switch (type) {
+                    case 0:
+                        addDimLinear(creationInterface);
+                        break;
 
-                case 1:
-                    addDimAligned(creationInterface);
-                    break;
+                    case 1:
+                        addDimAligned(creationInterface);
+                        break;
 
-                case 2:
-                    addDimAngular(creationInterface);
-                    break;
+                    case 2:
+                        addDimAngular(creationInterface);
+                        break;
 
-                case 3:
-                    addDimDiametric(creationInterface);
-                    break;
+                    case 3:
+                        addDimDiametric(creationInterface);
+                        break;
 
-                case 4:
-                    addDimRadial(creationInterface);
-                    break;
+                    case 4:
+                        addDimRadial(creationInterface);
+                        break;
 
-                case 5:
-                    addDimAngular3P(creationInterface);
-                    break;
+                    case 5:
+                        addDimAngular3P(creationInterface);
+                        break;
                 
-                case 6:
-                    addDimOrdinate(creationInterface);
-                    break;
+                    case 6:
+                        addDimOrdinate(creationInterface);
+                        break;
 
-                default:
-                    break;
+                    default:
+                        break;
+                    }
                 }
-            }
-            break;
+                break;
 
-        case DL_ENTITY_LEADER:
-            addLeader(creationInterface);
-            break;
+            case DL_ENTITY_LEADER:
+                addLeader(creationInterface);
+                break;
 
-        case DL_ENTITY_HATCH:
-            //addHatch(creationInterface);
-            handleHatchData(creationInterface);
-            break;
+            case DL_ENTITY_HATCH:
+                //addHatch(creationInterface);
+                handleHatchData(creationInterface);
+                break;
 
-        case DL_ENTITY_IMAGE:
-            addImage(creationInterface);
-            break;
+            case DL_ENTITY_IMAGE:
+                addImage(creationInterface);
+                break;
 
-        case DL_ENTITY_IMAGEDEF:
-            addImageDef(creationInterface);
-            break;
+            case DL_ENTITY_IMAGEDEF:
+                addImageDef(creationInterface);
+                break;
 
-        case DL_ENTITY_TRACE:
-            addTrace(creationInterface);
-            break;
+            case DL_ENTITY_TRACE:
+                addTrace(creationInterface);
+                break;
         
-        case DL_ENTITY_3DFACE:
-            add3dFace(creationInterface);
-            break;
+            case DL_ENTITY_3DFACE:
+                add3dFace(creationInterface);
+                break;
 
-        case DL_ENTITY_SOLID:
-            addSolid(creationInterface);
-            break;
+            case DL_ENTITY_SOLID:
+                addSolid(creationInterface);
+                break;
 
-        case DL_ENTITY_SEQEND:
-            endSequence(creationInterface);
-            break;
+            case DL_ENTITY_SEQEND:
+                endSequence(creationInterface);
+                break;
 
-        default:
-            break;
-        }
+            default:
+                break;
+            }
 
-        creationInterface->endSection();
+            creationInterface->endSection();
+        }
 
         // reset all values (they are not persistent and only this
         //  way we can set defaults for omitted values)
@@ -585,6 +1204,7 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
         firstHatchLoop = true;
         //firstHatchEdge = true;
         hatchEdge = DL_HatchEdgeData();
+        hatchBoundary.dropEdge();
         //xRecordHandle = "";
         xRecordValues = false;
 
@@ -592,96 +1212,40 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
         // Now determine what the next entity or setting type is
 
         int prevEntity = currentObjectType;
+        if (prevEntity==DL_ENDBLK) {
+            inBlock = false;
+            skipBlock = false;
+        }
 
         // Read DXF variable:
         if (groupValue[0]=='$') {
-            currentObjectType = DL_SETTING;
+            setObjectType(DL_SETTING);
             settingKey = groupValue;
         }
 
-        // Read Layers:
-        else if (groupValue=="LAYER") {
-            currentObjectType = DL_LAYER;
-        }
-
-        // Read Linetypes:
-        else if (groupValue=="LTYPE") {
-            currentObjectType = DL_LINETYPE;
-        }
-
-        // Read Blocks:
-        else if (groupValue=="BLOCK") {
-            currentObjectType = DL_BLOCK;
-        } else if (groupValue=="ENDBLK") {
-            currentObjectType = DL_ENDBLK;
-        }
-
-        // Read text styles:
-        else if (groupValue=="STYLE") {
-            currentObjectType = DL_STYLE;
-        }
-
-        // Read entities:
-        else if (groupValue=="POINT") {
-            currentObjectType = DL_ENTITY_POINT;
-        } else if (groupValue=="LINE") {
-            currentObjectType = DL_ENTITY_LINE;
-        } else if (groupValue=="XLINE") {
-            currentObjectType = DL_ENTITY_XLINE;
-        } else if (groupValue=="RAY") {
-            currentObjectType = DL_ENTITY_RAY;
-        } else if (groupValue=="POLYLINE") {
-            currentObjectType = DL_ENTITY_POLYLINE;
-        } else if (groupValue=="LWPOLYLINE") {
-            currentObjectType = DL_ENTITY_LWPOLYLINE;
-        } else if (groupValue=="VERTEX") {
-            currentObjectType = DL_ENTITY_VERTEX;
-        } else if (groupValue=="SPLINE") {
-            currentObjectType = DL_ENTITY_SPLINE;
-        } else if (groupValue=="ARC") {
-            currentObjectType = DL_ENTITY_ARC;
-        } else if (groupValue=="ELLIPSE") {
-            currentObjectType = DL_ENTITY_ELLIPSE;
-        } else if (groupValue=="CIRCLE") {
-            currentObjectType = DL_ENTITY_CIRCLE;
-        } else if (groupValue=="INSERT") {
-            currentObjectType = DL_ENTITY_INSERT;
-        } else if (groupValue=="TEXT") {
-            currentObjectType = DL_ENTITY_TEXT;
-        } else if (groupValue=="MTEXT") {
-            currentObjectType = DL_ENTITY_MTEXT;
-        } else if (groupValue=="ARCALIGNEDTEXT") {
-            currentObjectType = DL_ENTITY_ARCALIGNEDTEXT;
-        } else if (groupValue=="ATTRIB") {
-            currentObjectType = DL_ENTITY_ATTRIB;
-        } else if (groupValue=="DIMENSION") {
-            currentObjectType = DL_ENTITY_DIMENSION;
-        } else if (groupValue=="LEADER") {
-            currentObjectType = DL_ENTITY_LEADER;
-        } else if (groupValue=="HATCH") {
-            currentObjectType = DL_ENTITY_HATCH;
-        } else if (groupValue=="IMAGE") {
-            currentObjectType = DL_ENTITY_IMAGE;
-        } else if (groupValue=="IMAGEDEF") {
-            currentObjectType = DL_ENTITY_IMAGEDEF;
-        } else if (groupValue=="TRACE") {
-           currentObjectType = DL_ENTITY_TRACE;
-        } else if (groupValue=="SOLID") {
-           currentObjectType = DL_ENTITY_SOLID;
-        } else if (groupValue=="3DFACE") {
-           currentObjectType = DL_ENTITY_3DFACE;
-        } else if (groupValue=="SEQEND") {
-            currentObjectType = DL_ENTITY_SEQEND;
-        } else if (groupValue=="XRECORD") {
-            currentObjectType = DL_XRECORD;
-        } else if (groupValue=="DICTIONARY") {
-            currentObjectType = DL_DICTIONARY;
+        // Read layers, line types, blocks, text styles, entities, ...:
+        else {
+            setObjectType(getObjectType(groupValue));
+        }
+
+        if (currentObjectType==DL_BLOCK) {
+            inBlock = true;
+        }
+
+        // Vertices and attributes belong to the preceding POLYLINE or
+        // INSERT and are skipped with it:
+        if (currentObjectType==DL_ENTITY_VERTEX ||
+            currentObjectType==DL_ENTITY_ATTRIB ||
+            currentObjectType==DL_ENTITY_SEQEND) {
+            skipEntity = skipBlock || skipSequence;
         } else {
-            currentObjectType = DL_UNKNOWN;
+            skipSequence = false;
+            skipEntity = skipBlock;
         }
 
         // end of old style POLYLINE entity
-        if (prevEntity==DL_ENTITY_VERTEX && currentObjectType!=DL_ENTITY_VERTEX) {
+        if (prevEntity==DL_ENTITY_VERTEX && currentObjectType!=DL_ENTITY_VERTEX &&
+            !skipped) {
             endEntity(creationInterface);
         }
 
@@ -696,45 +1260,18 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
         // Group code does not indicate start of new entity or setting,
         // so this group must be continuation of data for the current
         // one.
+        if (skipEntity || isFiltered()) {
+            return false;
+        }
+
         if (groupCode<DL_DXF_MAXGROUPCODE) {
 
             bool handled = false;
 
-            switch (currentObjectType) {
-            case DL_ENTITY_MTEXT:
-                handled = handleMTextData(creationInterface);
-                break;
-
-            case DL_ENTITY_LWPOLYLINE:
-                handled = handleLWPolylineData(creationInterface);
-                break;
-
-            case DL_ENTITY_SPLINE:
-                handled = handleSplineData(creationInterface);
-                break;
-
-            case DL_ENTITY_LEADER:
-                handled = handleLeaderData(creationInterface);
-                break;
-
-            case DL_ENTITY_HATCH:
-                handled = handleHatchData(creationInterface);
-                break;
-
-            case DL_XRECORD:
-                handled = handleXRecordData(creationInterface);
-                break;
-
-            case DL_DICTIONARY:
-                handled = handleDictionaryData(creationInterface);
-                break;
-
-            case DL_LINETYPE:
-                handled = handleLinetypeData(creationInterface);
-                break;
-
-            default:
-                break;
+            // Types with groups that are not simply stored (see
+            // getDataHandler()):
+            if (dataHandler!=NULL) {
+                handled = (this->*dataHandler)(creationInterface);
             }
 
             // Always try to handle XData, unless we're in an XData record:
@@ -744,7 +1281,11 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
 
             if (!handled) {
                 // Normal group / value pair:
-                values[groupCode] = groupValue;
+                if (groupHasReal) {
+                    values.setReal(groupCode, groupValue, groupReal);
+                } else {
+                    values.set(groupCode, groupValue);
+                }
             }
         }
 
@@ -755,6 +1296,159 @@ bool DL_Dxf::processDXFGroup(DL_CreationInterface* creationInterface,
 
 
 
+/**
+ * Sets the type of the current entity, table entry or object and looks
+ * up its data handler.
+ */
+void DL_Dxf::setObjectType(int objectType) {
+    currentObjectType = objectType;
+    dataHandler = getDataHandler(objectType);
+}
+
+
+
+namespace {
+
+/**
+ * @return \p objectType if \p name is \p typeName, DL_UNKNOWN otherwise.
+ *      \p name must have the length of \p typeName.
+ */
+inline int matchType(const std::string& name, const char* typeName,
+                     int objectType) {
+    return memcmp(name.data(), typeName, name.length())==0 ?
+           objectType : DL_UNKNOWN;
+}
+
+}
+
+
+/**
+ * @return Object type (DL_ENTITY_LINE, DL_LAYER, ...) for the given
+ *      value of a group with code 0 or DL_UNKNOWN.
+ *
+ * The names are told apart by their length and one or two characters,
+ * so every name is compared to at most one candidate.
+ */
+int DL_Dxf::getObjectType(const std::string& name) {
+    const char* s = name.data();
+
+    switch (name.length()) {
+    case 3:
+        switch (s[0]) {
+        case 'A': return matchType(name, "ARC", DL_ENTITY_ARC);
+        case 'R': return matchType(name, "RAY", DL_ENTITY_RAY);
+        }
+        break;
+
+    case 4:
+        switch (s[0]) {
+        case 'L': return matchType(name, "LINE", DL_ENTITY_LINE);
+        case 'T': return matchType(name, "TEXT", DL_ENTITY_TEXT);
+        }
+        break;
+
+    case 5:
+        switch (s[0]) {
+        case 'B': return matchType(name, "BLOCK", DL_BLOCK);
+        case 'H': return matchType(name, "HATCH", DL_ENTITY_HATCH);
+        case 'I': return matchType(name, "IMAGE", DL_ENTITY_IMAGE);
+        case 'L':
+            if (s[1]=='A') {
+                return matchType(name, "LAYER", DL_LAYER);
+            }
+            return matchType(name, "LTYPE", DL_LINETYPE);
+        case 'M': return matchType(name, "MTEXT", DL_ENTITY_MTEXT);
+        case 'P': return matchType(name, "POINT", DL_ENTITY_POINT);
+        case 'S':
+            if (s[1]=='T') {
+                return matchType(name, "STYLE", DL_STYLE);
+            }
+            return matchType(name, "SOLID", DL_ENTITY_SOLID);
+        case 'T': return matchType(name, "TRACE", DL_ENTITY_TRACE);
+        case 'X': return matchType(name, "XLINE", DL_ENTITY_XLINE);
+        }
+        break;
+
+    case 6:
+        switch (s[0]) {
+        case '3': return matchType(name, "3DFACE", DL_ENTITY_3DFACE);
+        case 'A': return matchType(name, "ATTRIB", DL_ENTITY_ATTRIB);
+        case 'C': return matchType(name, "CIRCLE", DL_ENTITY_CIRCLE);
+        case 'E': return matchType(name, "ENDBLK", DL_ENDBLK);
+        case 'I': return matchType(name, "INSERT", DL_ENTITY_INSERT);
+        case 'L': return matchType(name, "LEADER", DL_ENTITY_LEADER);
+        case 'S':
+            if (s[1]=='P') {
+                return matchType(name, "SPLINE", DL_ENTITY_SPLINE);
+            }
+            return matchType(name, "SEQEND", DL_ENTITY_SEQEND);
+        case 'V': return matchType(name, "VERTEX", DL_ENTITY_VERTEX);
+        }
+        break;
+
+    case 7:
+        switch (s[0]) {
+        case 'E': return matchType(name, "ELLIPSE", DL_ENTITY_ELLIPSE);
+        case 'X': return matchType(name, "XRECORD", DL_XRECORD);
+        }
+        break;
+
+    case 8:
+        switch (s[0]) {
+        case 'I': return matchType(name, "IMAGEDEF", DL_ENTITY_IMAGEDEF);
+        case 'P': return matchType(name, "POLYLINE", DL_ENTITY_POLYLINE);
+        }
+        break;
+
+    case 9:
+        return matchType(name, "DIMENSION", DL_ENTITY_DIMENSION);
+
+    case 10:
+        switch (s[0]) {
+        case 'D': return matchType(name, "DICTIONARY", DL_DICTIONARY);
+        case 'L': return matchType(name, "LWPOLYLINE", DL_ENTITY_LWPOLYLINE);
+        }
+        break;
+
+    case 14:
+        return matchType(name, "ARCALIGNEDTEXT", DL_ENTITY_ARCALIGNEDTEXT);
+    }
+
+    return DL_UNKNOWN;
+}
+
+
+
+/**
+ * @return Handler for the groups of the given object type which are
+ *      not simply stored in the group values (vertices of light weight
+ *      polylines, hatch loops, xrecord data, ...) or NULL.
+ */
+DL_Dxf::DataHandler DL_Dxf::getDataHandler(int objectType) {
+    static const struct {
+        int objectType;
+        DataHandler handler;
+    } handlers[] = {
+        { DL_ENTITY_MTEXT,      &DL_Dxf::handleMTextData },
+        { DL_ENTITY_LWPOLYLINE, &DL_Dxf::handleLWPolylineData },
+        { DL_ENTITY_SPLINE,     &DL_Dxf::handleSplineData },
+        { DL_ENTITY_LEADER,     &DL_Dxf::handleLeaderData },
+        { DL_ENTITY_HATCH,      &DL_Dxf::handleHatchData },
+        { DL_XRECORD,           &DL_Dxf::handleXRecordData },
+        { DL_DICTIONARY,        &DL_Dxf::handleDictionaryData },
+        { DL_LINETYPE,          &DL_Dxf::handleLinetypeData }
+    };
+
+    for (size_t i=0; i<sizeof(handlers)/sizeof(handlers[0]); ++i) {
+        if (handlers[i].objectType==objectType) {
+            return handlers[i].handler;
+        }
+    }
+    return NULL;
+}
+
+
+
 /**
  * Adds a comment from the DXF file.
  */
@@ -776,11 +1470,7 @@ void DL_Dxf::addDictionaryEntry(DL_CreationInterface* creationInterface) {
  * Adds a variable from the DXF file.
  */
 void DL_Dxf::addSetting(DL_CreationInterface* creationInterface) {
-    int c = -1;
-    std::map<int,std::string>::iterator it = values.begin();
-    if (it!=values.end()) {
-        c = it->first;
-    }
+    int c = values.firstCode();
 //    for (int i=0; i<=380; ++i) {
 //        if (values[i][0]!='\0') {
 //            c = i;
@@ -790,10 +1480,10 @@ void DL_Dxf::addSetting(DL_CreationInterface* creationInterface) {
 
     // string
     if (c>=0 && c<=9) {
-        creationInterface->setVariableString(settingKey, values[c], c);
+        creationInterface->setVariableString(settingKey, getStringValue(c, ""), c);
  #ifdef DL_COMPAT
         // backwards compatibility:
-        creationInterface->setVariableString(settingKey.c_str(), values[c].c_str(), c);
+        creationInterface->setVariableString(settingKey.c_str(), values.get(c), c);
  #endif
     }
     // vector
@@ -887,7 +1577,7 @@ void DL_Dxf::addLinetype(DL_CreationInterface* creationInterface) {
  */
 bool DL_Dxf::handleLinetypeData(DL_CreationInterface* creationInterface) {
     if (groupCode == 49) {
-        creationInterface->addLinetypeDash(toReal(groupValue));
+        creationInterface->addLinetypeDash(getGroupRealValue());
         return true;
     }
 
@@ -1024,13 +1714,8 @@ void DL_Dxf::addPolyline(DL_CreationInterface* creationInterface) {
     maxVertices = std::min(maxVertices, vertexIndex+1);
 
     if (currentObjectType==DL_ENTITY_LWPOLYLINE) {
-        for (int i=0; i<maxVertices; i++) {
-            DL_VertexData d(vertices[i*4],
-                            vertices[i*4+1],
-                            vertices[i*4+2],
-                            vertices[i*4+3]);
-
-            creationInterface->addVertex(d);
+        if (maxVertices>0) {
+            creationInterface->addVertices(&vertices[0], maxVertices);
         }
         creationInterface->endEntity();
     }
@@ -1347,7 +2032,7 @@ bool DL_Dxf::handleXRecordData(DL_CreationInterface* creationInterface) {
 
     // double:
     else if ((groupCode>=10 && groupCode<=59) || (groupCode>=110 && groupCode<=149) || (groupCode>=210 && groupCode<=239)) {
-        creationInterface->addXRecordReal(groupCode, toReal(groupValue));
+        creationInterface->addXRecordReal(groupCode, getGroupRealValue());
         return true;
     }
 
@@ -1389,7 +2074,7 @@ bool DL_Dxf::handleXData(DL_CreationInterface* creationInterface) {
         return true;
     }
     else if (groupCode>=1010 && groupCode<=1059) {
-        creationInterface->addXDataReal(groupCode, toReal(groupValue));
+        creationInterface->addXDataReal(groupCode, getGroupRealValue());
         return true;
     }
     else if (groupCode>=1060 && groupCode<=1070) {
@@ -1421,20 +2106,12 @@ bool DL_Dxf::handleMTextData(DL_CreationInterface* creationInterface) {
  * Handles additional polyline data.
  */
 bool DL_Dxf::handleLWPolylineData(DL_CreationInterface* /*creationInterface*/) {
-    // Allocate LWPolyline vertices (group code 90):
+    // Size LWPolyline vertices (group code 90). The buffer keeps its
+    // capacity, vertices are cleared when their group code 10 is read:
     if (groupCode==90) {
         maxVertices = toInt(groupValue);
-        if (maxVertices>0) {
-            if (vertices!=NULL) {
-                delete[] vertices;
-            }
-            vertices = new double[4*maxVertices];
-            for (int i=0; i<maxVertices; ++i) {
-                vertices[i*4] = 0.0;
-                vertices[i*4+1] = 0.0;
-                vertices[i*4+2] = 0.0;
-                vertices[i*4+3] = 0.0;
-            }
+        if (maxVertices>0 && (size_t)maxVertices>vertices.size()) {
+            vertices.resize(maxVertices);
         }
         vertexIndex=-1;
         return true;
@@ -1446,14 +2123,25 @@ bool DL_Dxf::handleLWPolylineData(DL_CreationInterface* /*creationInterface*/) {
 
         if (vertexIndex<maxVertices-1 && groupCode==10) {
             vertexIndex++;
+            vertices[vertexIndex] = DL_VertexData();
         }
 
-        if (groupCode<=30) {
-            if (vertexIndex>=0 && vertexIndex<maxVertices) {
-                vertices[4*vertexIndex + (groupCode/10-1)] = toReal(groupValue);
+        if (vertexIndex>=0 && vertexIndex<maxVertices) {
+            DL_VertexData& v = vertices[vertexIndex];
+            switch (groupCode) {
+            case 10:
+                v.x = getGroupRealValue();
+                break;
+            case 20:
+                v.y = getGroupRealValue();
+                break;
+            case 30:
+                v.z = getGroupRealValue();
+                break;
+            default:
+                v.bulge = getGroupRealValue();
+                break;
             }
-        } else if (groupCode==42 && vertexIndex<maxVertices) {
-            vertices[4*vertexIndex + 3] = toReal(groupValue);
         }
         return true;
     }
@@ -1469,15 +2157,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
     // Allocate Spline knots (group code 72):
     if (groupCode==72) {
         maxKnots = toInt(groupValue);
-        if (maxKnots>0) {
-            if (knots!=NULL) {
-                delete[] knots;
-            }
-            knots = new double[maxKnots];
-            for (int i=0; i<maxKnots; ++i) {
-                knots[i] = 0.0;
-            }
-        }
+        knots.assign(std::max(maxKnots, 0), 0.0);
         knotIndex=-1;
         return true;
     }
@@ -1485,22 +2165,8 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
     // Allocate Spline control points / weights (group code 73):
     else if (groupCode==73) {
         maxControlPoints = toInt(groupValue);
-        if (maxControlPoints>0) {
-            if (controlPoints!=NULL) {
-                delete[] controlPoints;
-            }
-            if (weights!=NULL) {
-                delete[] weights;
-            }
-            controlPoints = new double[3*maxControlPoints];
-            weights = new double[maxControlPoints];
-            for (int i=0; i<maxControlPoints; ++i) {
-                controlPoints[i*3] = 0.0;
-                controlPoints[i*3+1] = 0.0;
-                controlPoints[i*3+2] = 0.0;
-                weights[i] = 1.0;
-            }
-        }
+        controlPoints.assign(3*std::max(maxControlPoints, 0), 0.0);
+        weights.assign(std::max(maxControlPoints, 0), 1.0);
         controlPointIndex=-1;
         weightIndex=-1;
         return true;
@@ -1509,17 +2175,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
     // Allocate Spline fit points (group code 74):
     else if (groupCode==74) {
         maxFitPoints = toInt(groupValue);
-        if (maxFitPoints>0) {
-            if (fitPoints!=NULL) {
-                delete[] fitPoints;
-            }
-            fitPoints = new double[3*maxFitPoints];
-            for (int i=0; i<maxFitPoints; ++i) {
-                fitPoints[i*3] = 0.0;
-                fitPoints[i*3+1] = 0.0;
-                fitPoints[i*3+2] = 0.0;
-            }
-        }
+        fitPoints.assign(3*std::max(maxFitPoints, 0), 0.0);
         fitPointIndex=-1;
         return true;
     }
@@ -1528,7 +2184,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
     else if (groupCode==40) {
         if (knotIndex<maxKnots-1) {
             knotIndex++;
-            knots[knotIndex] = toReal(groupValue);
+            knots[knotIndex] = getGroupRealValue();
         }
         return true;
     }
@@ -1542,7 +2198,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
         }
 
         if (controlPointIndex>=0 && controlPointIndex<maxControlPoints) {
-            controlPoints[3*controlPointIndex + (groupCode/10-1)] = toReal(groupValue);
+            controlPoints[3*controlPointIndex + (groupCode/10-1)] = getGroupRealValue();
         }
         return true;
     }
@@ -1554,7 +2210,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
         }
 
         if (fitPointIndex>=0 && fitPointIndex<maxFitPoints) {
-            fitPoints[3*fitPointIndex + ((groupCode-1)/10-1)] = toReal(groupValue);
+            fitPoints[3*fitPointIndex + ((groupCode-1)/10-1)] = getGroupRealValue();
         }
         return true;
     }
@@ -1567,7 +2223,7 @@ bool DL_Dxf::handleSplineData(DL_CreationInterface* /*creationInterface*/) {
         }
 
         if (weightIndex>=0 && weightIndex<maxControlPoints) {
-            weights[weightIndex] = toReal(groupValue);
+            weights[weightIndex] = getGroupRealValue();
         }
         return true;
     }
@@ -1583,17 +2239,7 @@ bool DL_Dxf::handleLeaderData(DL_CreationInterface* /*creationInterface*/) {
     // Allocate Leader vertices (group code 76):
     if (groupCode==76) {
         maxLeaderVertices = toInt(groupValue);
-        if (maxLeaderVertices>0) {
-            if (leaderVertices!=NULL) {
-                delete[] leaderVertices;
-            }
-            leaderVertices = new double[3*maxLeaderVertices];
-            for (int i=0; i<maxLeaderVertices; ++i) {
-                leaderVertices[i*3] = 0.0;
-                leaderVertices[i*3+1] = 0.0;
-                leaderVertices[i*3+2] = 0.0;
-            }
-        }
+        leaderVertices.assign(3*std::max(maxLeaderVertices, 0), 0.0);
         leaderVertexIndex=-1;
         return true;
     }
@@ -1609,7 +2255,7 @@ bool DL_Dxf::handleLeaderData(DL_CreationInterface* /*creationInterface*/) {
             if (leaderVertexIndex>=0 &&
                     leaderVertexIndex<maxLeaderVertices) {
                 leaderVertices[3*leaderVertexIndex + (groupCode/10-1)]
-                = toReal(groupValue);
+                = getGroupRealValue();
             }
         }
         return true;
@@ -1968,27 +2614,18 @@ void DL_Dxf::addHatch(DL_CreationInterface* creationInterface) {
                     getStringValue(2, ""));
 
     creationInterface->addHatch(hd);
-
-    for (unsigned int i=0; i<hatchEdges.size(); i++) {
-        creationInterface->addHatchLoop(DL_HatchLoopData(hatchEdges[i].size()));
-        for (unsigned int k=0; k<hatchEdges[i].size(); k++) {
-            creationInterface->addHatchEdge(DL_HatchEdgeData(hatchEdges[i][k]));
-        }
-    }
-
+    creationInterface->addHatchBoundary(hatchBoundary);
     creationInterface->endEntity();
 }
 
-void DL_Dxf::addHatchLoop() {
+void DL_Dxf::addHatchLoop(int flags) {
     addHatchEdge();
-    hatchEdges.push_back(std::vector<DL_HatchEdgeData>());
+    hatchBoundary.addLoop(flags);
 }
 
 void DL_Dxf::addHatchEdge() {
     if (hatchEdge.defined) {
-        if (hatchEdges.size()>0) {
-            hatchEdges.back().push_back(hatchEdge);
-        }
+        hatchBoundary.endEdge(hatchEdge);
         hatchEdge = DL_HatchEdgeData();
     }
 }
@@ -2001,14 +2638,14 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
     // or new loop with individual edges, group code 93
     if (groupCode==92 || groupCode==93) {
         if (firstHatchLoop) {
-            hatchEdges.clear();
+            hatchBoundary.clear();
             firstHatchLoop = false;
         }
         if (groupCode==92 && (toInt(groupValue)&2)==2) {
-            addHatchLoop();
+            addHatchLoop(toInt(groupValue));
         }
         if (groupCode==93) {
-            addHatchLoop();
+            addHatchLoop(getIntValue(92, 0));
         }
         return true;
     }
@@ -2034,18 +2671,17 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
         switch (groupCode) {
         case 10:
             hatchEdge.type = 0;
-            hatchEdge.vertices.push_back(std::vector<double>());
-            hatchEdge.vertices.back().push_back(toReal(groupValue));
+            hatchBoundary.addVertex(getGroupRealValue());
             return true;
         case 20:
-            if (!hatchEdge.vertices.empty()) {
-                hatchEdge.vertices.back().push_back(toReal(groupValue));
+            if (hatchBoundary.lastVertex()!=NULL) {
+                hatchBoundary.lastVertex()->y = getGroupRealValue();
                 hatchEdge.defined = true;
             }
             return true;
         case 42:
-            if (!hatchEdge.vertices.empty()) {
-                hatchEdge.vertices.back().push_back(toReal(groupValue));
+            if (hatchBoundary.lastVertex()!=NULL) {
+                hatchBoundary.setBulge(getGroupRealValue());
                 hatchEdge.defined = true;
             }
             return true;
@@ -2056,16 +2692,16 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
         if (hatchEdge.type==1) {
             switch (groupCode) {
             case 10:
-                hatchEdge.x1 = toReal(groupValue);
+                hatchEdge.x1 = getGroupRealValue();
                 return true;
             case 20:
-                hatchEdge.y1 = toReal(groupValue);
+                hatchEdge.y1 = getGroupRealValue();
                 return true;
             case 11:
-                hatchEdge.x2 = toReal(groupValue);
+                hatchEdge.x2 = getGroupRealValue();
                 return true;
             case 21:
-                hatchEdge.y2 = toReal(groupValue);
+                hatchEdge.y2 = getGroupRealValue();
                 hatchEdge.defined = true;
                 return true;
             }
@@ -2075,19 +2711,19 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
         if (hatchEdge.type==2) {
             switch(groupCode) {
             case 10:
-                hatchEdge.cx = toReal(groupValue);
+                hatchEdge.cx = getGroupRealValue();
                 return true;
             case 20:
-                hatchEdge.cy = toReal(groupValue);
+                hatchEdge.cy = getGroupRealValue();
                 return true;
             case 40:
-                hatchEdge.radius = toReal(groupValue);
+                hatchEdge.radius = getGroupRealValue();
                 return true;
             case 50:
-                hatchEdge.angle1 = toReal(groupValue)/360.0*2*M_PI;
+                hatchEdge.angle1 = getGroupRealValue()/360.0*2*M_PI;
                 return true;
             case 51:
-                hatchEdge.angle2 = toReal(groupValue)/360.0*2*M_PI;
+                hatchEdge.angle2 = getGroupRealValue()/360.0*2*M_PI;
                 return true;
             case 73:
                 hatchEdge.ccw = (bool)toInt(groupValue);
@@ -2100,25 +2736,25 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
         if (hatchEdge.type==3) {
             switch (groupCode) {
             case 10:
-                hatchEdge.cx = toReal(groupValue);
+                hatchEdge.cx = getGroupRealValue();
                 return true;
             case 20:
-                hatchEdge.cy = toReal(groupValue);
+                hatchEdge.cy = getGroupRealValue();
                 return true;
             case 11:
-                hatchEdge.mx = toReal(groupValue);
+                hatchEdge.mx = getGroupRealValue();
                 return true;
             case 21:
-                hatchEdge.my = toReal(groupValue);
+                hatchEdge.my = getGroupRealValue();
                 return true;
             case 40:
-                hatchEdge.ratio = toReal(groupValue);
+                hatchEdge.ratio = getGroupRealValue();
                 return true;
             case 50:
-                hatchEdge.angle1 = toReal(groupValue)/360.0*2*M_PI;
+                hatchEdge.angle1 = getGroupRealValue()/360.0*2*M_PI;
                 return true;
             case 51:
-                hatchEdge.angle2 = toReal(groupValue)/360.0*2*M_PI;
+                hatchEdge.angle2 = getGroupRealValue()/360.0*2*M_PI;
                 return true;
             case 73:
                 hatchEdge.ccw = (bool)toInt(groupValue);
@@ -2149,52 +2785,48 @@ bool DL_Dxf::handleHatchData(DL_CreationInterface* creationInterface) {
                 hatchEdge.nFit = toInt(groupValue);
                 return true;
             case 40:
-                if (hatchEdge.knots.size() < hatchEdge.nKnots) {
-                    hatchEdge.knots.push_back(toReal(groupValue));
+                if (hatchBoundary.getOpenKnots() < hatchEdge.nKnots) {
+                    hatchBoundary.addKnot(getGroupRealValue());
                 }
                 return true;
             case 10:
-                if (hatchEdge.controlPoints.size() < hatchEdge.nControl) {
-                    std::vector<double> v;
-                    v.push_back(toReal(groupValue));
-                    hatchEdge.controlPoints.push_back(v);
+                if (hatchBoundary.getOpenControlPoints() < hatchEdge.nControl) {
+                    hatchBoundary.addControlPoint(getGroupRealValue());
                 }
                 return true;
             case 20:
-                if (!hatchEdge.controlPoints.empty() && hatchEdge.controlPoints.back().size()==1) {
-                    hatchEdge.controlPoints.back().push_back(toReal(groupValue));
+                if (hatchBoundary.lastControlPoint()!=NULL) {
+                    hatchBoundary.lastControlPoint()->y = getGroupRealValue();
                 }
                 hatchEdge.defined = true;
                 return true;
             case 42:
-                if (hatchEdge.weights.size() < hatchEdge.nControl) {
-                    hatchEdge.weights.push_back(toReal(groupValue));
+                if (hatchBoundary.getOpenWeights() < hatchEdge.nControl) {
+                    hatchBoundary.addWeight(getGroupRealValue());
                 }
                 return true;
             case 11:
-                if (hatchEdge.fitPoints.size() < hatchEdge.nFit) {
-                    std::vector<double> v;
-                    v.push_back(toReal(groupValue));
-                    hatchEdge.fitPoints.push_back(v);
+                if (hatchBoundary.getOpenFitPoints() < hatchEdge.nFit) {
+                    hatchBoundary.addFitPoint(getGroupRealValue());
                 }
                 return true;
             case 21:
-                if (!hatchEdge.fitPoints.empty() && hatchEdge.fitPoints.back().size()==1) {
-                    hatchEdge.fitPoints.back().push_back(toReal(groupValue));
+                if (hatchBoundary.lastFitPoint()!=NULL) {
+                    hatchBoundary.lastFitPoint()->y = getGroupRealValue();
                 }
                 hatchEdge.defined = true;
                 return true;
             case 12:
-                hatchEdge.startTangentX = toReal(groupValue);
+                hatchEdge.startTangentX = getGroupRealValue();
                 return true;
             case 22:
-                hatchEdge.startTangentY = toReal(groupValue);
+                hatchEdge.startTangentY = getGroupRealValue();
                 return true;
             case 13:
-                hatchEdge.endTangentX = toReal(groupValue);
+                hatchEdge.endTangentX = getGroupRealValue();
                 return true;
             case 23:
-                hatchEdge.endTangentY = toReal(groupValue);
+                hatchEdge.endTangentY = getGroupRealValue();
                 return true;
             }
         }
@@ -2232,7 +2864,7 @@ void DL_Dxf::addImage(DL_CreationInterface* creationInterface) {
 
     creationInterface->addImage(id);
     creationInterface->endEntity();
-    currentObjectType = DL_UNKNOWN;
+    setObjectType(DL_UNKNOWN);
 }
 
 
@@ -2247,7 +2879,7 @@ void DL_Dxf::addImageDef(DL_CreationInterface* creationInterface) {
 
     creationInterface->linkImage(id);
     creationInterface->endEntity();
-    currentObjectType = DL_UNKNOWN;
+    setObjectType(DL_UNKNOWN);
 }
 
 
@@ -5248,6 +5880,207 @@ int DL_Dxf::getLibVersion(const std::string& str) {
     }
 }
 
+/**
+ * Converts the given characters into an int. Leading spaces and tabs
+ * and a sign are accepted, conversion stops at the first character
+ * that is not a digit. Returns 0 if there are no digits.
+ *
+ * Same result as strtol(str, NULL, 10) but without the need for a
+ * terminating '\\0'.
+ */
+int DL_Dxf::toInt(const char* str, size_t length) {
+    const char* p = str;
+    const char* end = str + length;
+
+    while (p<end && (*p==' ' || *p=='\t')) {
+        ++p;
+    }
+
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+')) {
+        negative = (*p=='-');
+        ++p;
+    }
+
+    long long ret = 0;
+    while (p<end && *p>='0' && *p<='9') {
+        if (ret<=(long long)std::numeric_limits<int>::max()+1) {
+            ret = ret*10 + (*p-'0');
+        }
+        ++p;
+    }
+
+    if (negative) {
+        ret = -ret;
+    }
+    if (ret>std::numeric_limits<int>::max()) {
+        return std::numeric_limits<int>::max();
+    }
+    if (ret<std::numeric_limits<int>::min()) {
+        return std::numeric_limits<int>::min();
+    }
+    return (int)ret;
+}
+
+
+
+namespace {
+
+/**
+ * Converts a number with '.' as decimal separator and a terminating
+ * '\\0' using the "C" locale, independent of the locale of the process.
+ * The locale object is created once (thread safe) and only read after
+ * that, so this may be called from several parsers at the same time.
+ */
+double strtodC(const char* str) {
+#if defined(_WIN32)
+    static _locale_t cLocale = _create_locale(LC_NUMERIC, "C");
+    return _strtod_l(str, NULL, cLocale);
+#elif defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+    static locale_t cLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+    return strtod_l(str, NULL, cLocale);
+#else
+    std::istringstream istr(str);
+    istr.imbue(std::locale::classic());
+    double ret = 0.0;
+    istr >> ret;
+    return ret;
+#endif
+}
+
+}
+
+
+
+/**
+ * @brief Converts the given characters into a double.
+ *
+ * Both '.' and ',' are accepted as decimal separator. The conversion
+ * does not depend on the locale, allocates no memory and does not need
+ * a terminating '\\0'. Leading spaces and tabs are skipped, conversion
+ * stops at the first character which is not part of the number.
+ * Returns 0.0 if there are no digits.
+ *
+ * Numbers with up to 15 significant digits and a small exponent (which
+ * covers most DXF coordinates) are converted exactly with a single
+ * floating point multiplication or division. All other numbers are
+ * handed to strtod in the "C" locale, so the result is always the
+ * correctly rounded double.
+ */
+double DL_Dxf::toReal(const char* str, size_t length) {
+    // exact powers of ten representable as double:
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    // largest integer for which all smaller integers are exact doubles:
+    static const unsigned long long maxExactMantissa = 1ULL<<53;
+
+    const char* p = str;
+    const char* end = str + length;
+
+    while (p<end && (*p==' ' || *p=='\t')) {
+        ++p;
+    }
+    const char* numberStart = p;
+
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+')) {
+        negative = (*p=='-');
+        ++p;
+    }
+
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+
+    // integer part:
+    for (; p<end && *p>='0' && *p<='9'; ++p) {
+        ++digits;
+        if (mantissa==0 && *p=='0') {
+            continue;
+        }
+        if (significantDigits<19) {
+            mantissa = mantissa*10 + (*p-'0');
+        } else {
+            exponent++;
+        }
+        ++significantDigits;
+    }
+
+    // fraction:
+    if (p<end && (*p=='.' || *p==',')) {
+        ++p;
+        for (; p<end && *p>='0' && *p<='9'; ++p) {
+            ++digits;
+            if (mantissa==0 && *p=='0') {
+                exponent--;
+                continue;
+            }
+            if (significantDigits<19) {
+                mantissa = mantissa*10 + (*p-'0');
+                exponent--;
+            }
+            ++significantDigits;
+        }
+    }
+
+    if (digits==0) {
+        return 0.0;
+    }
+
+    // exponent:
+    if (p<end && (*p=='e' || *p=='E')) {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e<end && (*e=='-' || *e=='+')) {
+            negativeExponent = (*e=='-');
+            ++e;
+        }
+        if (e<end && *e>='0' && *e<='9') {
+            int value = 0;
+            for (; e<end && *e>='0' && *e<='9'; ++e) {
+                if (value<100000) {
+                    value = value*10 + (*e-'0');
+                }
+            }
+            exponent += negativeExponent ? -value : value;
+            p = e;
+        }
+    }
+
+    // fast path, exact since both operands are exact doubles:
+    if (significantDigits<=19 && mantissa<=maxExactMantissa &&
+        exponent>=-22 && exponent<=22) {
+
+        double ret = (double)mantissa;
+        if (exponent<0) {
+            ret /= powersOfTen[-exponent];
+        } else {
+            ret *= powersOfTen[exponent];
+        }
+        return negative ? -ret : ret;
+    }
+
+    // slow path, copy the number with '.' as separator:
+    char buffer[64];
+    size_t numberLength = p - numberStart;
+    if (numberLength<sizeof(buffer)) {
+        for (size_t i=0; i<numberLength; ++i) {
+            buffer[i] = numberStart[i]==',' ? '.' : numberStart[i];
+        }
+        buffer[numberLength] = '\0';
+        return strtodC(buffer);
+    }
+
+    std::string number(numberStart, numberLength);
+    std::replace(number.begin(), number.end(), ',', '.');
+    return strtodC(number.c_str());
+}
+
+
+
 /**
  * Converts the given string into a double or returns the given
  * default valud (def) if value is NULL or empty.
@@ -5330,3 +6163,109 @@ void DL_Dxf::test() {
 }
 
 
+/**
+ * Checks toReal() and toInt() against a corpus of numbers as they
+ * appear in DXF files, including exponents, signs and ',' as decimal
+ * separator. Prints every mismatch.
+ *
+ * @retval true if all conversions are correct.
+ */
+bool DL_Dxf::testNumbers() {
+    struct RealCase {
+        const char* str;
+        double expected;
+    };
+    static const RealCase realCases[] = {
+        { "0", 0.0 },
+        { "0.0", 0.0 },
+        { "-0.0", -0.0 },
+        { "1", 1.0 },
+        { "+1", 1.0 },
+        { "-1", -1.0 },
+        { "2.5", 2.5 },
+        { "2,5", 2.5 },
+        { "-2,5", -2.5 },
+        { ".5", 0.5 },
+        { ",5", 0.5 },
+        { "5.", 5.0 },
+        { "  12.75", 12.75 },
+        { "\t12.75", 12.75 },
+        { "12.75  ", 12.75 },
+        { "0.1", 0.1 },
+        { "0.2", 0.2 },
+        { "0.3", 0.3 },
+        { "1e5", 1e5 },
+        { "1E5", 1e5 },
+        { "1e+5", 1e5 },
+        { "1e-5", 1e-5 },
+        { "-1.5e-3", -1.5e-3 },
+        { "1,5E+02", 150.0 },
+        { "1.0E-10", 1e-10 },
+        { "6.02214076E23", 6.02214076e23 },
+        { "1e308", 1e308 },
+        { "4.9e-324", 4.9e-324 },
+        { "1e-400", 0.0 },
+        { "123456789012345", 123456789012345.0 },
+        { "9007199254740993", 9007199254740993.0 },
+        { "-901.7028240884519", -901.7028240884519 },
+        { "-402.0205799512289", -402.0205799512289 },
+        { "3.141592653589793", 3.141592653589793 },
+        { "0.30000000000000004", 0.30000000000000004 },
+        { "0.000000000000000000000000001", 1e-27 },
+        { "100000000000000000000000", 1e23 },
+        { "1.7976931348623157e308", 1.7976931348623157e308 },
+        { "2.2250738585072014e-308", 2.2250738585072014e-308 },
+        { "1.00000000000000000000000000001", 1.0 },
+        { "1e", 1.0 },
+        { "1e+", 1.0 },
+        { "12abc", 12.0 },
+        { "1.2.3", 1.2 },
+        { "", 0.0 },
+        { "-", 0.0 },
+        { "abc", 0.0 }
+    };
+
+    struct IntCase {
+        const char* str;
+        int expected;
+    };
+    static const IntCase intCases[] = {
+        { "0", 0 },
+        { "10", 10 },
+        { "  10", 10 },
+        { "+10", 10 },
+        { "-10", -10 },
+        { "370", 370 },
+        { "1071", 1071 },
+        { "007", 7 },
+        { "42abc", 42 },
+        { "2147483647", 2147483647 },
+        { "-2147483648", -2147483647-1 },
+        { "", 0 },
+        { "-", 0 }
+    };
+
+    bool ok = true;
+
+    for (size_t i=0; i<sizeof(realCases)/sizeof(realCases[0]); ++i) {
+        const RealCase& c = realCases[i];
+        double value = toReal(c.str, strlen(c.str));
+        if (value!=c.expected || std::signbit(value)!=std::signbit(c.expected)) {
+            std::cout << "toReal('" << c.str << "'): " << value
+                      << " expected: " << c.expected << "\n";
+            ok = false;
+        }
+    }
+
+    for (size_t i=0; i<sizeof(intCases)/sizeof(intCases[0]); ++i) {
+        const IntCase& c = intCases[i];
+        int value = toInt(c.str, strlen(c.str));
+        if (value!=c.expected) {
+            std::cout << "toInt('" << c.str << "'): " << value
+                      << " expected: " << c.expected << "\n";
+            ok = false;
+        }
+    }
+
+    return ok;
+}
@@ -27,16 +27,26 @@
 
 #include "dl_global.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <limits>
+#include <map>
+#include <set>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
 #include <sstream>
-#include <map>
+#include <vector>
 
 #include "dl_attributes.h"
+#include "dl_binaryreader.h"
 #include "dl_codes.h"
 #include "dl_entities.h"
+#include "dl_groupvalues.h"
+#include "dl_hatchboundary.h"
+#include "dl_inputsource.h"
+#include "dl_linereader.h"
 #include "dl_writer_ascii.h"
 
 #ifdef _WIN32
@@ -64,6 +74,21 @@ class DL_WriterA;
 #define DL_VERSION_REV      0
 #define DL_VERSION_BUILD    0
 
+/**
+ * Progress of a running \p DL_Dxf::in() call, passed to the callback
+ * set with \p DL_Dxf::setProgressCallback().
+ */
+struct DXFLIB_EXPORT DL_ProgressData {
+    /** Bytes read so far. For compressed input these are decompressed bytes. */
+    size_t bytes;
+    /** Size of the input in bytes, 0 if it is not known in advance. */
+    size_t totalBytes;
+    /** Entities and other objects (groups with code 0) read so far. */
+    size_t entities;
+    /** Seconds since reading started. */
+    double elapsed;
+};
+
 #define DL_UNKNOWN               0
 #define DL_LAYER                10
 #define DL_BLOCK                11
@@ -117,6 +142,11 @@ class DL_WriterA;
  * Special colors are 0 (=BYBLOCK) and 256 (=BYLAYER).
  * Special linetypes are "BYLAYER" and "BYBLOCK".
  *
+ * All parser state is kept per instance and the process wide locale
+ * is never changed, so several instances can read different files
+ * in parallel threads. A single instance must not be used by more
+ * than one thread at a time.
+ *
  * @author Andrew Mustun
  */
 class DXFLIB_EXPORT DL_Dxf {
@@ -128,15 +158,100 @@ public:
             DL_CreationInterface* creationInterface);
     bool readDxfGroups(FILE* fp,
                        DL_CreationInterface* creationInterface);
-    static bool getStrippedLine(std::string& s, unsigned int size,
-                               FILE* stream, bool stripSpace = true);
     
     bool readDxfGroups(std::stringstream& stream,
                        DL_CreationInterface* creationInterface);
     bool in(std::stringstream &stream,
             DL_CreationInterface* creationInterface);
-    static bool getStrippedLine(std::string& s, unsigned int size,
-                               std::stringstream& stream, bool stripSpace = true);
+
+    bool in(const char* data, size_t size,
+            DL_CreationInterface* creationInterface);
+    bool inMapped(const std::string& file,
+                  DL_CreationInterface* creationInterface);
+    bool in(DL_InputSource& source,
+            DL_CreationInterface* creationInterface);
+
+    bool readDxfGroups(DL_CreationInterface* creationInterface);
+
+    /**
+     * Sets the number of worker threads used to parse the ENTITIES
+     * section of input read from memory (\p in(const char*, ...) and
+     * \p inMapped()). 0 or 1 parses everything on the calling thread.
+     */
+    void setEntityThreads(int threads) {
+        entityThreads = threads;
+    }
+
+    int getEntityThreads() const {
+        return entityThreads;
+    }
+
+    /**
+     * Sets the layers to read. Entities on other layers are dropped as
+     * soon as their layer (group code 8) is read, before any other of
+     * their values is converted, and are not reported to the creation
+     * interface. For input read from memory, blocks which are only
+     * inserted on other layers are skipped as well. An empty set reads
+     * all layers.
+     */
+    void setLayerFilter(const std::set<std::string>& layers) {
+        layerFilter = layers;
+    }
+
+    const std::set<std::string>& getLayerFilter() const {
+        return layerFilter;
+    }
+
+    /**
+     * Reads only what is needed for geometry: the LAYER table, the
+     * BLOCKS and the ENTITIES section. All other sections (HEADER,
+     * CLASSES, OBJECTS, ...) and tables are skipped by searching the
+     * raw input for their end, their groups are not tokenized and no
+     * settings, line types, styles or objects are reported.
+     */
+    void setGeometryOnly(bool on) {
+        geometryOnly = on;
+    }
+
+    bool isGeometryOnly() const {
+        return geometryOnly;
+    }
+
+    /**
+     * @return Number of bytes skipped by the last call of \p in() or
+     *      \p inMapped() in geometry only mode.
+     */
+    size_t getSkippedBytes() const {
+        return skippedBytes;
+    }
+
+    /**
+     * Calls \p callback while reading, every time another \p interval
+     * bytes have been read and once at the end of the input. An empty
+     * function removes the callback, reading then costs no extra time.
+     */
+    void setProgressCallback(const std::function<void(const DL_ProgressData&)>& callback,
+                             size_t interval = 1024*1024) {
+        progressCallback = callback;
+        progressInterval = interval;
+        nextProgress = callback ? interval : std::numeric_limits<size_t>::max();
+        progressStart = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Sets a flag owned by the caller which is checked between groups.
+     * As soon as it is true (set by another thread or by the progress
+     * callback), reading stops and \p in() returns false. NULL removes
+     * the flag.
+     */
+    void setCancelFlag(const std::atomic<bool>* flag) {
+        cancelFlag = flag;
+    }
+
+    /** @return true if the last \p in() call was stopped by the cancel flag. */
+    bool isCanceled() const {
+        return canceled;
+    }
 
     static bool stripWhiteSpace(char** s, bool stripSpaces = true);
 
@@ -186,7 +301,7 @@ public:
     void addLeader(DL_CreationInterface* creationInterface);
 
     void addHatch(DL_CreationInterface* creationInterface);
-    void addHatchLoop();
+    void addHatchLoop(int flags);
     void addHatchEdge();
     bool handleHatchData(DL_CreationInterface* creationInterface);
 
@@ -403,114 +518,174 @@ public:
     int getLibVersion(const std::string &str);
 
     static void test();
+    static bool testNumbers();
 
     bool hasValue(int code) {
-        return values.count(code)==1;
+        return values.has(code);
     }
 
     int getIntValue(int code, int def) {
         if (!hasValue(code)) {
             return def;
         }
-        return toInt(values[code]);
+        return toInt(values.get(code), values.length(code));
     }
 
     int toInt(const std::string& str) {
-        char* p;
-        return strtol(str.c_str(), &p, 10);
+        return toInt(str.data(), str.length());
     }
 
+    static int toInt(const char* str, size_t length);
+
     int getInt16Value(int code, int def) {
         if (!hasValue(code)) {
             return def;
         }
-        return toInt16(values[code]);
+        return toInt16(values.get(code));
     }
 
     int toInt16(const std::string& str) {
+        return toInt16(str.c_str());
+    }
+
+    int toInt16(const char* str) {
         char* p;
-        return strtol(str.c_str(), &p, 16);
+        return strtol(str, &p, 16);
     }
 
     bool toBool(const std::string& str) {
-        char* p;
-        return (bool)strtol(str.c_str(), &p, 10);
+        return toInt(str)!=0;
     }
 
     std::string getStringValue(int code, const std::string& def) {
         if (!hasValue(code)) {
             return def;
         }
-        return values[code];
+        return std::string(values.get(code), values.length(code));
     }
 
     double getRealValue(int code, double def) {
         if (!hasValue(code)) {
             return def;
         }
-        return toReal(values[code]);
+        double real;
+        if (values.getReal(code, real)) {
+            return real;
+        }
+        return toReal(values.get(code), values.length(code));
+    }
+
+    /**
+     * @return Value of the current group as double. Binary DXF input
+     * delivers the number already decoded.
+     */
+    double getGroupRealValue() {
+        if (groupHasReal) {
+            return groupReal;
+        }
+        return toReal(groupValue);
     }
 
     double toReal(const std::string& str) {
-        double ret;
-        // make sure the real value uses '.' not ',':
-        std::string str2 = str;
-        std::replace(str2.begin(), str2.end(), ',', '.');
-        // make sure c++ expects '.' not ',':
-        std::istringstream istr(str2);
-        //istr.imbue(std::locale("C"));
-        istr >> ret;
-        return ret;
+        return toReal(str.data(), str.length());
     }
 
+    static double toReal(const char* str, size_t length);
+
 private:
+    bool readBinaryDxfGroups(DL_CreationInterface* creationInterface);
+    bool readEntitiesParallel(const char* data, size_t size,
+                              DL_CreationInterface* creationInterface);
+    void readEntityChunk(const char* data, size_t size,
+                         DL_CreationInterface* creationInterface);
+    void findRequiredBlocks(const char* data, size_t size);
+    bool isFiltered();
+    void resetFilterState();
+    void skipUnusedGroups();
+    void startProgress(size_t totalBytes);
+    bool updateProgress(size_t position);
+    void reportProgress(size_t position);
+    bool finishProgress(size_t position);
+
+    /**
+     * Counts the group just read and reports the progress or checks
+     * the cancel flag if necessary.
+     *
+     * @retval true if reading has been canceled.
+     */
+    bool pollProgress(size_t position) {
+        if (groupCode==0) {
+            entityCount++;
+        }
+        return (position>=nextProgress || cancelFlag!=NULL) &&
+               updateProgress(position);
+    }
+
+    typedef bool (DL_Dxf::*DataHandler)(DL_CreationInterface* creationInterface);
+    void setObjectType(int objectType);
+    static int getObjectType(const std::string& name);
+    static DataHandler getDataHandler(int objectType);
+
     DL_Codes::version version;
 
+    // Buffered cursor over the lines of the current input:
+    DL_LineReader lineReader;
+    // Decoder for binary DXF input, used instead of the line reader:
+    DL_BinaryReader binaryReader;
+    bool binaryInput = false;
+
     std::string polylineLayer;
-    double* vertices;
+    // Point buffers of the current LWPOLYLINE, SPLINE or LEADER. They
+    // keep their capacity from entity to entity:
+    std::vector<DL_VertexData> vertices;
     int maxVertices;
     int vertexIndex;
     
-    double* knots;
+    std::vector<double> knots;
     int maxKnots;
     int knotIndex;
     
-    double* weights;
+    std::vector<double> weights;
     int weightIndex;
 
-    double* controlPoints;
+    std::vector<double> controlPoints;
     int maxControlPoints;
     int controlPointIndex;
 
-    double* fitPoints = nullptr;
+    std::vector<double> fitPoints;
     int maxFitPoints = 0;
     int fitPointIndex = 0;
 
-    double* leaderVertices = nullptr;
+    std::vector<double> leaderVertices;
     int maxLeaderVertices = 0;
     int leaderVertexIndex = 0;
 
     bool firstHatchLoop = 0;
+    // Scalar values of the hatch edge which is read, its points go
+    // straight into hatchBoundary:
     DL_HatchEdgeData hatchEdge;
-    std::vector<std::vector<DL_HatchEdgeData> > hatchEdges;
+    DL_HatchBoundary hatchBoundary;
 
     std::string xRecordHandle;
     bool xRecordValues;
 
-    // Only the useful part of the group code
-    std::string groupCodeTmp;
-    // ...same as integer
+    // Group code of the current group
     unsigned int groupCode = 0;
     // Only the useful part of the group value
     std::string groupValue;
+    // Decoded value of the current group if it is a double from binary input
+    bool groupHasReal = false;
+    double groupReal = 0.0;
     // Current entity type
     int currentObjectType = 0;
+    // Handler for the groups of the current entity type, see getDataHandler()
+    DataHandler dataHandler = NULL;
     // Value of the current setting
     char settingValue[DL_DXF_MAXLINE+1];
     // Key of the current setting (e.g. "$ACADVER")
     std::string settingKey;
-    // Stores the group codes
-    std::map<int, std::string> values;
+    // Stores the group values of the current entity by group code
+    DL_GroupValues values;
     // First call of this method. We initialize all group values in
     //  the first call.
     bool firstCall = 0;
@@ -522,6 +697,35 @@ private:
     unsigned long appDictionaryHandle = 0;
     // handle of standard text style, referenced by dimstyle:
     unsigned long styleHandleStd = 0;
+    // Number of threads used for the ENTITIES section:
+    int entityThreads = 0;
+    // Layers to read, all if empty:
+    std::set<std::string> layerFilter;
+    // Blocks needed for the filtered layers, used if filterBlocks is set:
+    std::set<std::string> requiredBlocks;
+    bool filterBlocks = false;
+    // Reading a block definition:
+    bool inBlock = false;
+    // Dropping the current block, entity or POLYLINE / INSERT sequence:
+    bool skipBlock = false;
+    bool skipEntity = false;
+    bool skipSequence = false;
+    // Skipping sections and tables not needed for geometry:
+    bool geometryOnly = false;
+    size_t skippedBytes = 0;
+    // The last group started a section / a table:
+    bool atSectionStart = false;
+    bool atTableStart = false;
+    // Progress reporting and cancellation, see setProgressCallback():
+    std::function<void(const DL_ProgressData&)> progressCallback;
+    size_t progressInterval = 1024*1024;
+    // Position of the next report, never reached without callback:
+    size_t nextProgress = std::numeric_limits<size_t>::max();
+    size_t progressTotal = 0;
+    size_t entityCount = 0;
+    std::chrono::steady_clock::time_point progressStart;
+    const std::atomic<bool>* cancelFlag = NULL;
+    bool canceled = false;
 };
 
 #endif
@@ -0,0 +1,772 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#include "dl_entitybuffer.h"
+
+
+
+/**
+ * Sends all recorded events to the given creation interface in the
+ * order they were recorded.
+ */
+void DL_EntityBuffer::replay(DL_CreationInterface* creationInterface) const {
+    for (size_t i=0; i<events.size(); ++i) {
+        const Event& e = events[i];
+        switch (e.kind) {
+        case EvAddLayer:
+            creationInterface->addLayer(layerData[e.index]);
+            break;
+        case EvAddLinetype:
+            creationInterface->addLinetype(linetypeData[e.index]);
+            break;
+        case EvAddBlock:
+            creationInterface->addBlock(blockData[e.index]);
+            break;
+        case EvAddTextStyle:
+            creationInterface->addTextStyle(styleData[e.index]);
+            break;
+        case EvAddPoint:
+            creationInterface->addPoint(pointData[e.index]);
+            break;
+        case EvAddLine:
+            creationInterface->addLine(lineData[e.index]);
+            break;
+        case EvAddXLine:
+            creationInterface->addXLine(xLineData[e.index]);
+            break;
+        case EvAddRay:
+            creationInterface->addRay(rayData[e.index]);
+            break;
+        case EvAddArc:
+            creationInterface->addArc(arcData[e.index]);
+            break;
+        case EvAddCircle:
+            creationInterface->addCircle(circleData[e.index]);
+            break;
+        case EvAddEllipse:
+            creationInterface->addEllipse(ellipseData[e.index]);
+            break;
+        case EvAddPolyline:
+            creationInterface->addPolyline(polylineData[e.index]);
+            break;
+        case EvAddVertex:
+            creationInterface->addVertex(vertexData[e.index]);
+            break;
+        case EvAddVertices:
+            creationInterface->addVertices(&vertexData[e.index], e.code);
+            break;
+        case EvAddSpline:
+            creationInterface->addSpline(splineData[e.index]);
+            break;
+        case EvAddControlPoint:
+            creationInterface->addControlPoint(controlPointData[e.index]);
+            break;
+        case EvAddFitPoint:
+            creationInterface->addFitPoint(fitPointData[e.index]);
+            break;
+        case EvAddKnot:
+            creationInterface->addKnot(knotData[e.index]);
+            break;
+        case EvAddInsert:
+            creationInterface->addInsert(insertData[e.index]);
+            break;
+        case EvAddTrace:
+            creationInterface->addTrace(traceData[e.index]);
+            break;
+        case EvAdd3dFace:
+            creationInterface->add3dFace(face3dData[e.index]);
+            break;
+        case EvAddSolid:
+            creationInterface->addSolid(solidData[e.index]);
+            break;
+        case EvAddMText:
+            creationInterface->addMText(mTextData[e.index]);
+            break;
+        case EvAddText:
+            creationInterface->addText(textData[e.index]);
+            break;
+        case EvAddArcAlignedText:
+            creationInterface->addArcAlignedText(arcAlignedTextData[e.index]);
+            break;
+        case EvAddAttribute:
+            creationInterface->addAttribute(attributeData[e.index]);
+            break;
+        case EvAddLeader:
+            creationInterface->addLeader(leaderData[e.index]);
+            break;
+        case EvAddLeaderVertex:
+            creationInterface->addLeaderVertex(leaderVertexData[e.index]);
+            break;
+        case EvAddHatch:
+            creationInterface->addHatch(hatchData[e.index]);
+            break;
+        case EvAddImage:
+            creationInterface->addImage(imageData[e.index]);
+            break;
+        case EvLinkImage:
+            creationInterface->linkImage(imageDefData[e.index]);
+            break;
+        case EvAddHatchLoop:
+            creationInterface->addHatchLoop(hatchLoopData[e.index]);
+            break;
+        case EvAddHatchEdge:
+            creationInterface->addHatchEdge(hatchEdgeData[e.index]);
+            break;
+        case EvAddHatchBoundary:
+            creationInterface->addHatchBoundary(hatchBoundaries[e.index]);
+            break;
+        case EvAddDictionary:
+            creationInterface->addDictionary(dictionaryData[e.index]);
+            break;
+        case EvAddDictionaryEntry:
+            creationInterface->addDictionaryEntry(dictionaryEntryData[e.index]);
+            break;
+        case EvSetAttributes:
+            creationInterface->setAttributes(attributeList[e.index]);
+            break;
+        case EvAddDimAlign:
+            creationInterface->addDimAlign(dimAlignedData[e.index].first,
+                                           dimAlignedData[e.index].second);
+            break;
+        case EvAddDimLinear:
+            creationInterface->addDimLinear(dimLinearData[e.index].first,
+                                            dimLinearData[e.index].second);
+            break;
+        case EvAddDimRadial:
+            creationInterface->addDimRadial(dimRadialData[e.index].first,
+                                            dimRadialData[e.index].second);
+            break;
+        case EvAddDimDiametric:
+            creationInterface->addDimDiametric(dimDiametricData[e.index].first,
+                                               dimDiametricData[e.index].second);
+            break;
+        case EvAddDimAngular:
+            creationInterface->addDimAngular(dimAngularData[e.index].first,
+                                             dimAngularData[e.index].second);
+            break;
+        case EvAddDimAngular3P:
+            creationInterface->addDimAngular3P(dimAngular3PData[e.index].first,
+                                               dimAngular3PData[e.index].second);
+            break;
+        case EvAddDimOrdinate:
+            creationInterface->addDimOrdinate(dimOrdinateData[e.index].first,
+                                              dimOrdinateData[e.index].second);
+            break;
+        case EvAddMTextChunk:
+            creationInterface->addMTextChunk(strings[e.index]);
+            break;
+        case EvAddXRecord:
+            creationInterface->addXRecord(strings[e.index]);
+            break;
+        case EvAddXDataApp:
+            creationInterface->addXDataApp(strings[e.index]);
+            break;
+        case EvAddComment:
+            creationInterface->addComment(strings[e.index]);
+            break;
+        case EvAddXRecordString:
+            creationInterface->addXRecordString(e.code, strings[e.index]);
+            break;
+        case EvAddXDataString:
+            creationInterface->addXDataString(e.code, strings[e.index]);
+            break;
+        case EvAddXRecordReal:
+            creationInterface->addXRecordReal(e.code, reals[e.index]);
+            break;
+        case EvAddXDataReal:
+            creationInterface->addXDataReal(e.code, reals[e.index]);
+            break;
+        case EvAddXRecordInt:
+            creationInterface->addXRecordInt(e.code, ints[e.index]);
+            break;
+        case EvAddXRecordBool:
+            creationInterface->addXRecordBool(e.code, ints[e.index]!=0);
+            break;
+        case EvAddXDataInt:
+            creationInterface->addXDataInt(e.code, ints[e.index]);
+            break;
+        case EvAddLinetypeDash:
+            creationInterface->addLinetypeDash(reals[e.index]);
+            break;
+        case EvEndSection:
+            creationInterface->endSection();
+            break;
+        case EvEndBlock:
+            creationInterface->endBlock();
+            break;
+        case EvEndEntity:
+            creationInterface->endEntity();
+            break;
+        case EvEndSequence:
+            creationInterface->endSequence();
+            break;
+        case EvSetExtrusion:
+            creationInterface->setExtrusion(reals[e.index], reals[e.index+1],
+                                            reals[e.index+2], reals[e.index+3]);
+            break;
+        case EvSetVariableVector: {
+            const Variable& v = variables[e.index];
+            creationInterface->setVariableVector(v.key, v.v[0], v.v[1], v.v[2], e.code);
+            break;
+        }
+        case EvSetVariableString: {
+            const Variable& v = variables[e.index];
+            creationInterface->setVariableString(v.key, v.value, e.code);
+            break;
+        }
+        case EvSetVariableInt: {
+            const Variable& v = variables[e.index];
+            creationInterface->setVariableInt(v.key, (int)v.v[0], e.code);
+            break;
+        }
+        case EvSetVariableDouble: {
+            const Variable& v = variables[e.index];
+            creationInterface->setVariableDouble(v.key, v.v[0], e.code);
+            break;
+        }
+        }
+    }
+}
+
+
+
+/**
+ * Removes all recorded events.
+ */
+void DL_EntityBuffer::clear() {
+    events.clear();
+    layerData.clear();
+    linetypeData.clear();
+    blockData.clear();
+    styleData.clear();
+    pointData.clear();
+    lineData.clear();
+    xLineData.clear();
+    rayData.clear();
+    arcData.clear();
+    circleData.clear();
+    ellipseData.clear();
+    polylineData.clear();
+    vertexData.clear();
+    splineData.clear();
+    controlPointData.clear();
+    fitPointData.clear();
+    knotData.clear();
+    insertData.clear();
+    traceData.clear();
+    face3dData.clear();
+    solidData.clear();
+    mTextData.clear();
+    textData.clear();
+    arcAlignedTextData.clear();
+    attributeData.clear();
+    leaderData.clear();
+    leaderVertexData.clear();
+    hatchData.clear();
+    imageData.clear();
+    imageDefData.clear();
+    hatchLoopData.clear();
+    hatchEdgeData.clear();
+    hatchBoundaries.clear();
+    dictionaryData.clear();
+    dictionaryEntryData.clear();
+    attributeList.clear();
+    dimAlignedData.clear();
+    dimLinearData.clear();
+    dimRadialData.clear();
+    dimDiametricData.clear();
+    dimAngularData.clear();
+    dimAngular3PData.clear();
+    dimOrdinateData.clear();
+    variables.clear();
+    strings.clear();
+    reals.clear();
+    ints.clear();
+}
+
+
+
+void DL_EntityBuffer::addLayer(const DL_LayerData& data) {
+    record(EvAddLayer, layerData.size());
+    layerData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addLinetype(const DL_LinetypeData& data) {
+    record(EvAddLinetype, linetypeData.size());
+    linetypeData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addBlock(const DL_BlockData& data) {
+    record(EvAddBlock, blockData.size());
+    blockData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addTextStyle(const DL_StyleData& data) {
+    record(EvAddTextStyle, styleData.size());
+    styleData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addPoint(const DL_PointData& data) {
+    record(EvAddPoint, pointData.size());
+    pointData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addLine(const DL_LineData& data) {
+    record(EvAddLine, lineData.size());
+    lineData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addXLine(const DL_XLineData& data) {
+    record(EvAddXLine, xLineData.size());
+    xLineData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addRay(const DL_RayData& data) {
+    record(EvAddRay, rayData.size());
+    rayData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addArc(const DL_ArcData& data) {
+    record(EvAddArc, arcData.size());
+    arcData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addCircle(const DL_CircleData& data) {
+    record(EvAddCircle, circleData.size());
+    circleData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addEllipse(const DL_EllipseData& data) {
+    record(EvAddEllipse, ellipseData.size());
+    ellipseData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addPolyline(const DL_PolylineData& data) {
+    record(EvAddPolyline, polylineData.size());
+    polylineData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addVertex(const DL_VertexData& data) {
+    record(EvAddVertex, vertexData.size());
+    vertexData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addVertices(const DL_VertexData* data, int count) {
+    record(EvAddVertices, vertexData.size(), count);
+    vertexData.insert(vertexData.end(), data, data+count);
+}
+
+
+
+void DL_EntityBuffer::addSpline(const DL_SplineData& data) {
+    record(EvAddSpline, splineData.size());
+    splineData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addControlPoint(const DL_ControlPointData& data) {
+    record(EvAddControlPoint, controlPointData.size());
+    controlPointData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addFitPoint(const DL_FitPointData& data) {
+    record(EvAddFitPoint, fitPointData.size());
+    fitPointData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addKnot(const DL_KnotData& data) {
+    record(EvAddKnot, knotData.size());
+    knotData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addInsert(const DL_InsertData& data) {
+    record(EvAddInsert, insertData.size());
+    insertData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addTrace(const DL_TraceData& data) {
+    record(EvAddTrace, traceData.size());
+    traceData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::add3dFace(const DL_3dFaceData& data) {
+    record(EvAdd3dFace, face3dData.size());
+    face3dData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addSolid(const DL_SolidData& data) {
+    record(EvAddSolid, solidData.size());
+    solidData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addMText(const DL_MTextData& data) {
+    record(EvAddMText, mTextData.size());
+    mTextData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addText(const DL_TextData& data) {
+    record(EvAddText, textData.size());
+    textData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addArcAlignedText(const DL_ArcAlignedTextData& data) {
+    record(EvAddArcAlignedText, arcAlignedTextData.size());
+    arcAlignedTextData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addAttribute(const DL_AttributeData& data) {
+    record(EvAddAttribute, attributeData.size());
+    attributeData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addLeader(const DL_LeaderData& data) {
+    record(EvAddLeader, leaderData.size());
+    leaderData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addLeaderVertex(const DL_LeaderVertexData& data) {
+    record(EvAddLeaderVertex, leaderVertexData.size());
+    leaderVertexData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addHatch(const DL_HatchData& data) {
+    record(EvAddHatch, hatchData.size());
+    hatchData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addImage(const DL_ImageData& data) {
+    record(EvAddImage, imageData.size());
+    imageData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::linkImage(const DL_ImageDefData& data) {
+    record(EvLinkImage, imageDefData.size());
+    imageDefData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addHatchLoop(const DL_HatchLoopData& data) {
+    record(EvAddHatchLoop, hatchLoopData.size());
+    hatchLoopData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addHatchEdge(const DL_HatchEdgeData& data) {
+    record(EvAddHatchEdge, hatchEdgeData.size());
+    hatchEdgeData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addHatchBoundary(const DL_HatchBoundary& boundary) {
+    record(EvAddHatchBoundary, hatchBoundaries.size());
+    hatchBoundaries.push_back(boundary);
+}
+
+
+
+void DL_EntityBuffer::addDictionary(const DL_DictionaryData& data) {
+    record(EvAddDictionary, dictionaryData.size());
+    dictionaryData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addDictionaryEntry(const DL_DictionaryEntryData& data) {
+    record(EvAddDictionaryEntry, dictionaryEntryData.size());
+    dictionaryEntryData.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::setAttributes(const DL_Attributes& data) {
+    DL_CreationInterface::setAttributes(data);
+    record(EvSetAttributes, attributeList.size());
+    attributeList.push_back(data);
+}
+
+
+
+void DL_EntityBuffer::addDimAlign(const DL_DimensionData& data,
+                                  const DL_DimAlignedData& edata) {
+    record(EvAddDimAlign, dimAlignedData.size());
+    dimAlignedData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimLinear(const DL_DimensionData& data,
+                                   const DL_DimLinearData& edata) {
+    record(EvAddDimLinear, dimLinearData.size());
+    dimLinearData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimRadial(const DL_DimensionData& data,
+                                   const DL_DimRadialData& edata) {
+    record(EvAddDimRadial, dimRadialData.size());
+    dimRadialData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimDiametric(const DL_DimensionData& data,
+                                      const DL_DimDiametricData& edata) {
+    record(EvAddDimDiametric, dimDiametricData.size());
+    dimDiametricData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimAngular(const DL_DimensionData& data,
+                                    const DL_DimAngularData& edata) {
+    record(EvAddDimAngular, dimAngularData.size());
+    dimAngularData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimAngular3P(const DL_DimensionData& data,
+                                      const DL_DimAngular3PData& edata) {
+    record(EvAddDimAngular3P, dimAngular3PData.size());
+    dimAngular3PData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addDimOrdinate(const DL_DimensionData& data,
+                                     const DL_DimOrdinateData& edata) {
+    record(EvAddDimOrdinate, dimOrdinateData.size());
+    dimOrdinateData.push_back(std::make_pair(data, edata));
+}
+
+
+
+void DL_EntityBuffer::addMTextChunk(const std::string& value) {
+    record(EvAddMTextChunk, strings.size());
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXRecord(const std::string& value) {
+    record(EvAddXRecord, strings.size());
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXDataApp(const std::string& value) {
+    record(EvAddXDataApp, strings.size());
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addComment(const std::string& value) {
+    record(EvAddComment, strings.size());
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXRecordString(int code, const std::string& value) {
+    record(EvAddXRecordString, strings.size(), code);
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXDataString(int code, const std::string& value) {
+    record(EvAddXDataString, strings.size(), code);
+    strings.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXRecordReal(int code, double value) {
+    record(EvAddXRecordReal, reals.size(), code);
+    reals.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXDataReal(int code, double value) {
+    record(EvAddXDataReal, reals.size(), code);
+    reals.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXRecordInt(int code, int value) {
+    record(EvAddXRecordInt, ints.size(), code);
+    ints.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXRecordBool(int code, bool value) {
+    record(EvAddXRecordBool, ints.size(), code);
+    ints.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addXDataInt(int code, int value) {
+    record(EvAddXDataInt, ints.size(), code);
+    ints.push_back(value);
+}
+
+
+
+void DL_EntityBuffer::addLinetypeDash(double length) {
+    record(EvAddLinetypeDash, reals.size());
+    reals.push_back(length);
+}
+
+
+
+void DL_EntityBuffer::endSection() {
+    record(EvEndSection);
+}
+
+
+
+void DL_EntityBuffer::endBlock() {
+    record(EvEndBlock);
+}
+
+
+
+void DL_EntityBuffer::endEntity() {
+    record(EvEndEntity);
+}
+
+
+
+void DL_EntityBuffer::endSequence() {
+    record(EvEndSequence);
+}
+
+
+
+void DL_EntityBuffer::setExtrusion(double dx, double dy, double dz, double elevation) {
+    DL_CreationInterface::setExtrusion(dx, dy, dz, elevation);
+    record(EvSetExtrusion, reals.size());
+    reals.push_back(dx);
+    reals.push_back(dy);
+    reals.push_back(dz);
+    reals.push_back(elevation);
+}
+
+
+
+void DL_EntityBuffer::setVariableVector(const std::string& key,
+                                        double v1, double v2, double v3, int code) {
+    record(EvSetVariableVector, variables.size(), code);
+    variables.push_back(Variable(key, std::string(), v1, v2, v3));
+}
+
+
+
+void DL_EntityBuffer::setVariableString(const std::string& key,
+                                        const std::string& value, int code) {
+    record(EvSetVariableString, variables.size(), code);
+    variables.push_back(Variable(key, value));
+}
+
+
+
+void DL_EntityBuffer::setVariableInt(const std::string& key, int value, int code) {
+    record(EvSetVariableInt, variables.size(), code);
+    variables.push_back(Variable(key, std::string(), value));
+}
+
+
+
+void DL_EntityBuffer::setVariableDouble(const std::string& key, double value, int code) {
+    record(EvSetVariableDouble, variables.size(), code);
+    variables.push_back(Variable(key, std::string(), value));
+}
+
+// EOF
@@ -0,0 +1,284 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_ENTITYBUFFER_H
+#define DL_ENTITYBUFFER_H
+
+#include "dl_global.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dl_creationadapter.h"
+
+/**
+ * Creation interface that records all events it receives instead of
+ * handling them. The recorded events can later be sent to another
+ * creation interface in the original order using replay().
+ *
+ * DL_Dxf uses one buffer per chunk when the ENTITIES section is parsed
+ * on several threads. The chunks are replayed in file order so the
+ * application sees exactly the same sequence of calls as for a
+ * serial parse.
+ *
+ * processCodeValuePair() is not recorded.
+ */
+class DXFLIB_EXPORT DL_EntityBuffer : public DL_CreationAdapter {
+public:
+    DL_EntityBuffer() {}
+    virtual ~DL_EntityBuffer() {}
+
+    void replay(DL_CreationInterface* creationInterface) const;
+    void clear();
+
+    /** @return true if no events have been recorded. */
+    bool isEmpty() const {
+        return events.empty();
+    }
+
+    virtual void addLayer(const DL_LayerData& data);
+    virtual void addLinetype(const DL_LinetypeData& data);
+    virtual void addBlock(const DL_BlockData& data);
+    virtual void addTextStyle(const DL_StyleData& data);
+    virtual void addPoint(const DL_PointData& data);
+    virtual void addLine(const DL_LineData& data);
+    virtual void addXLine(const DL_XLineData& data);
+    virtual void addRay(const DL_RayData& data);
+    virtual void addArc(const DL_ArcData& data);
+    virtual void addCircle(const DL_CircleData& data);
+    virtual void addEllipse(const DL_EllipseData& data);
+    virtual void addPolyline(const DL_PolylineData& data);
+    virtual void addVertex(const DL_VertexData& data);
+    virtual void addVertices(const DL_VertexData* data, int count);
+    virtual void addSpline(const DL_SplineData& data);
+    virtual void addControlPoint(const DL_ControlPointData& data);
+    virtual void addFitPoint(const DL_FitPointData& data);
+    virtual void addKnot(const DL_KnotData& data);
+    virtual void addInsert(const DL_InsertData& data);
+    virtual void addTrace(const DL_TraceData& data);
+    virtual void add3dFace(const DL_3dFaceData& data);
+    virtual void addSolid(const DL_SolidData& data);
+    virtual void addMText(const DL_MTextData& data);
+    virtual void addText(const DL_TextData& data);
+    virtual void addArcAlignedText(const DL_ArcAlignedTextData& data);
+    virtual void addAttribute(const DL_AttributeData& data);
+    virtual void addLeader(const DL_LeaderData& data);
+    virtual void addLeaderVertex(const DL_LeaderVertexData& data);
+    virtual void addHatch(const DL_HatchData& data);
+    virtual void addImage(const DL_ImageData& data);
+    virtual void linkImage(const DL_ImageDefData& data);
+    virtual void addHatchLoop(const DL_HatchLoopData& data);
+    virtual void addHatchEdge(const DL_HatchEdgeData& data);
+    virtual void addHatchBoundary(const DL_HatchBoundary& boundary);
+    virtual void addDictionary(const DL_DictionaryData& data);
+    virtual void addDictionaryEntry(const DL_DictionaryEntryData& data);
+    virtual void setAttributes(const DL_Attributes& data);
+    virtual void addDimAlign(const DL_DimensionData& data,
+                             const DL_DimAlignedData& edata);
+    virtual void addDimLinear(const DL_DimensionData& data,
+                              const DL_DimLinearData& edata);
+    virtual void addDimRadial(const DL_DimensionData& data,
+                              const DL_DimRadialData& edata);
+    virtual void addDimDiametric(const DL_DimensionData& data,
+                                 const DL_DimDiametricData& edata);
+    virtual void addDimAngular(const DL_DimensionData& data,
+                               const DL_DimAngularData& edata);
+    virtual void addDimAngular3P(const DL_DimensionData& data,
+                                 const DL_DimAngular3PData& edata);
+    virtual void addDimOrdinate(const DL_DimensionData& data,
+                                const DL_DimOrdinateData& edata);
+    virtual void addMTextChunk(const std::string& value);
+    virtual void addXRecord(const std::string& value);
+    virtual void addXDataApp(const std::string& value);
+    virtual void addComment(const std::string& value);
+    virtual void addXRecordString(int code, const std::string& value);
+    virtual void addXDataString(int code, const std::string& value);
+    virtual void addXRecordReal(int code, double value);
+    virtual void addXDataReal(int code, double value);
+    virtual void addXRecordInt(int code, int value);
+    virtual void addXRecordBool(int code, bool value);
+    virtual void addXDataInt(int code, int value);
+    virtual void addLinetypeDash(double length);
+    virtual void endSection();
+    virtual void endBlock();
+    virtual void endEntity();
+    virtual void endSequence();
+    virtual void setExtrusion(double dx, double dy, double dz, double elevation);
+    virtual void setVariableVector(const std::string& key, double v1, double v2, double v3, int code);
+    virtual void setVariableString(const std::string& key, const std::string& value, int code);
+    virtual void setVariableInt(const std::string& key, int value, int code);
+    virtual void setVariableDouble(const std::string& key, double value, int code);
+
+private:
+    enum EventKind {
+        EvAddLayer,
+        EvAddLinetype,
+        EvAddBlock,
+        EvAddTextStyle,
+        EvAddPoint,
+        EvAddLine,
+        EvAddXLine,
+        EvAddRay,
+        EvAddArc,
+        EvAddCircle,
+        EvAddEllipse,
+        EvAddPolyline,
+        EvAddVertex,
+        EvAddVertices,
+        EvAddSpline,
+        EvAddControlPoint,
+        EvAddFitPoint,
+        EvAddKnot,
+        EvAddInsert,
+        EvAddTrace,
+        EvAdd3dFace,
+        EvAddSolid,
+        EvAddMText,
+        EvAddText,
+        EvAddArcAlignedText,
+        EvAddAttribute,
+        EvAddLeader,
+        EvAddLeaderVertex,
+        EvAddHatch,
+        EvAddImage,
+        EvLinkImage,
+        EvAddHatchLoop,
+        EvAddHatchEdge,
+        EvAddHatchBoundary,
+        EvAddDictionary,
+        EvAddDictionaryEntry,
+        EvSetAttributes,
+        EvAddDimAlign,
+        EvAddDimLinear,
+        EvAddDimRadial,
+        EvAddDimDiametric,
+        EvAddDimAngular,
+        EvAddDimAngular3P,
+        EvAddDimOrdinate,
+        EvAddMTextChunk,
+        EvAddXRecord,
+        EvAddXDataApp,
+        EvAddComment,
+        EvAddXRecordString,
+        EvAddXDataString,
+        EvAddXRecordReal,
+        EvAddXDataReal,
+        EvAddXRecordInt,
+        EvAddXRecordBool,
+        EvAddXDataInt,
+        EvAddLinetypeDash,
+        EvEndSection,
+        EvEndBlock,
+        EvEndEntity,
+        EvEndSequence,
+        EvSetExtrusion,
+        EvSetVariableVector,
+        EvSetVariableString,
+        EvSetVariableInt,
+        EvSetVariableDouble
+    };
+
+    /**
+     * One recorded call. index points into the storage for its kind,
+     * code is the group code or, for EvAddVertices, the vertex count.
+     */
+    struct Event {
+        Event(EventKind kind, size_t index, int code) :
+            kind(kind), code(code), index(index) {}
+        EventKind kind;
+        int code;
+        size_t index;
+    };
+
+    /** Recorded header variable. */
+    struct Variable {
+        Variable(const std::string& key, const std::string& value,
+                 double v1 = 0.0, double v2 = 0.0, double v3 = 0.0) :
+            key(key), value(value) {
+            v[0] = v1;
+            v[1] = v2;
+            v[2] = v3;
+        }
+        std::string key;
+        std::string value;
+        double v[3];
+    };
+
+    void record(EventKind kind, size_t index = 0, int code = 0) {
+        events.push_back(Event(kind, index, code));
+    }
+
+    std::vector<Event> events;
+    std::vector<DL_LayerData> layerData;
+    std::vector<DL_LinetypeData> linetypeData;
+    std::vector<DL_BlockData> blockData;
+    std::vector<DL_StyleData> styleData;
+    std::vector<DL_PointData> pointData;
+    std::vector<DL_LineData> lineData;
+    std::vector<DL_XLineData> xLineData;
+    std::vector<DL_RayData> rayData;
+    std::vector<DL_ArcData> arcData;
+    std::vector<DL_CircleData> circleData;
+    std::vector<DL_EllipseData> ellipseData;
+    std::vector<DL_PolylineData> polylineData;
+    std::vector<DL_VertexData> vertexData;
+    std::vector<DL_SplineData> splineData;
+    std::vector<DL_ControlPointData> controlPointData;
+    std::vector<DL_FitPointData> fitPointData;
+    std::vector<DL_KnotData> knotData;
+    std::vector<DL_InsertData> insertData;
+    std::vector<DL_TraceData> traceData;
+    std::vector<DL_3dFaceData> face3dData;
+    std::vector<DL_SolidData> solidData;
+    std::vector<DL_MTextData> mTextData;
+    std::vector<DL_TextData> textData;
+    std::vector<DL_ArcAlignedTextData> arcAlignedTextData;
+    std::vector<DL_AttributeData> attributeData;
+    std::vector<DL_LeaderData> leaderData;
+    std::vector<DL_LeaderVertexData> leaderVertexData;
+    std::vector<DL_HatchData> hatchData;
+    std::vector<DL_ImageData> imageData;
+    std::vector<DL_ImageDefData> imageDefData;
+    std::vector<DL_HatchLoopData> hatchLoopData;
+    std::vector<DL_HatchEdgeData> hatchEdgeData;
+    std::vector<DL_HatchBoundary> hatchBoundaries;
+    std::vector<DL_DictionaryData> dictionaryData;
+    std::vector<DL_DictionaryEntryData> dictionaryEntryData;
+    std::vector<DL_Attributes> attributeList;
+    std::vector<std::pair<DL_DimensionData, DL_DimAlignedData> > dimAlignedData;
+    std::vector<std::pair<DL_DimensionData, DL_DimLinearData> > dimLinearData;
+    std::vector<std::pair<DL_DimensionData, DL_DimRadialData> > dimRadialData;
+    std::vector<std::pair<DL_DimensionData, DL_DimDiametricData> > dimDiametricData;
+    std::vector<std::pair<DL_DimensionData, DL_DimAngularData> > dimAngularData;
+    std::vector<std::pair<DL_DimensionData, DL_DimAngular3PData> > dimAngular3PData;
+    std::vector<std::pair<DL_DimensionData, DL_DimOrdinateData> > dimOrdinateData;
+    std::vector<Variable> variables;
+    std::vector<std::string> strings;
+    std::vector<double> reals;
+    std::vector<int> ints;
+};
+
+#endif
+
+// EOF
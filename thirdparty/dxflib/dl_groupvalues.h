@@ -0,0 +1,181 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_GROUPVALUES_H
+#define DL_GROUPVALUES_H
+
+#include "dl_global.h"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "dl_codes.h"
+
+/**
+ * Group values of the entity or setting which is currently read.
+ *
+ * Values are looked up by group code in a flat table with one slot per
+ * code below DL_DXF_MAXGROUPCODE. The characters of all values are kept
+ * back to back in one buffer, each terminated with a '\\0'. Clearing
+ * the table between entities only bumps a generation counter and
+ * resets the buffer, so after the first few entities no memory is
+ * allocated any more.
+ *
+ * A repeated group code replaces the previous value (last one wins).
+ * The new value reuses the space of the old one if it fits, so long
+ * runs of a repeated code don't grow the buffer.
+ */
+class DXFLIB_EXPORT DL_GroupValues {
+public:
+    DL_GroupValues() :
+        entries(DL_DXF_MAXGROUPCODE),
+        generation(1),
+        firstGroupCode(-1) {
+    }
+
+    /**
+     * Removes all values.
+     */
+    void clear() {
+        generation++;
+        if (generation==0) {
+            // counter wrapped around, invalidate all entries explicitly:
+            for (size_t i=0; i<entries.size(); ++i) {
+                entries[i].generation = 0;
+            }
+            generation = 1;
+        }
+        buffer.clear();
+        firstGroupCode = -1;
+    }
+
+    /**
+     * Stores the given value for the given group code. Codes outside
+     * the table are ignored.
+     */
+    void set(int code, const char* value, size_t length) {
+        if (code<0 || code>=DL_DXF_MAXGROUPCODE) {
+            return;
+        }
+
+        Slot& slot = entries[code];
+        if (slot.generation!=generation || length>slot.capacity) {
+            slot.generation = generation;
+            slot.offset = buffer.size();
+            slot.capacity = length;
+            buffer.append(value, length);
+            buffer.push_back('\0');
+        } else {
+            memcpy(&buffer[slot.offset], value, length);
+            buffer[slot.offset+length] = '\0';
+        }
+        slot.length = length;
+        slot.hasReal = false;
+
+        if (firstGroupCode<0 || code<firstGroupCode) {
+            firstGroupCode = code;
+        }
+    }
+
+    void set(int code, const std::string& value) {
+        set(code, value.data(), value.length());
+    }
+
+    /**
+     * Stores the given value together with its already decoded number,
+     * which getReal() returns without converting the text again.
+     */
+    void setReal(int code, const std::string& value, double real) {
+        set(code, value.data(), value.length());
+        if (code>=0 && code<DL_DXF_MAXGROUPCODE) {
+            entries[code].real = real;
+            entries[code].hasReal = true;
+        }
+    }
+
+    /**
+     * @return true if the value of the given group code was stored with
+     * setReal(). The number is returned in \p real.
+     */
+    bool getReal(int code, double& real) const {
+        if (!entries[code].hasReal) {
+            return false;
+        }
+        real = entries[code].real;
+        return true;
+    }
+
+    /**
+     * @return true if a value is stored for the given group code.
+     */
+    bool has(int code) const {
+        return code>=0 && code<DL_DXF_MAXGROUPCODE &&
+               entries[code].generation==generation;
+    }
+
+    /**
+     * @return '\\0' terminated value of the given group code. Only valid
+     * if has() returns true for the code and until the table is
+     * modified.
+     */
+    const char* get(int code) const {
+        return buffer.data() + entries[code].offset;
+    }
+
+    /**
+     * @return Length of the value of the given group code.
+     */
+    size_t length(int code) const {
+        return entries[code].length;
+    }
+
+    /**
+     * @return Lowest group code with a value or -1 if the table is empty.
+     */
+    int firstCode() const {
+        return firstGroupCode;
+    }
+
+private:
+    struct Slot {
+        Slot() : generation(0), offset(0), length(0), capacity(0),
+            hasReal(false), real(0.0) {}
+
+        unsigned int generation;
+        size_t offset;
+        size_t length;
+        size_t capacity;
+        bool hasReal;
+        double real;
+    };
+
+    std::vector<Slot> entries;
+    std::string buffer;
+    unsigned int generation;
+    int firstGroupCode;
+};
+
+#endif
+
+// EOF
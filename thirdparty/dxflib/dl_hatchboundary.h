@@ -0,0 +1,353 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_HATCHBOUNDARY_H
+#define DL_HATCHBOUNDARY_H
+
+#include "dl_global.h"
+
+#include <stddef.h>
+#include <vector>
+
+#include "dl_entities.h"
+
+/**
+ * Read-only view of \p size consecutive elements starting at \p data.
+ */
+template <class T>
+struct DL_Span {
+    DL_Span() : data(NULL), size(0) {}
+    DL_Span(const T* data, size_t size) : data(data), size(size) {}
+
+    const T* begin() const {
+        return data;
+    }
+
+    const T* end() const {
+        return data + size;
+    }
+
+    bool empty() const {
+        return size==0;
+    }
+
+    const T& operator[](size_t i) const {
+        return data[i];
+    }
+
+    const T* data;
+    size_t size;
+};
+
+
+
+/**
+ * Point of a hatch boundary: a polyline vertex with its bulge or a
+ * spline control or fit point (bulge is 0).
+ */
+struct DXFLIB_EXPORT DL_HatchVertexData {
+    DL_HatchVertexData(double x = 0.0, double y = 0.0, double bulge = 0.0) :
+        x(x), y(y), bulge(bulge) {}
+
+    double x;
+    double y;
+    double bulge;
+};
+
+
+
+/**
+ * All boundary paths (loops) of a hatch in flat storage.
+ *
+ * Loops are ranges of one edge array. The points, knots and weights of
+ * polyline and spline edges are ranges of shared arrays, the vectors of
+ * the DL_HatchEdgeData of an edge stay empty. Clearing keeps the
+ * capacity of all arrays, so a boundary reused from hatch to hatch
+ * stops allocating after the first few hatches.
+ *
+ * Points, knots and weights are appended to the open edge at the end
+ * of the arrays. endEdge() closes it, or drops it together with its
+ * points.
+ */
+class DXFLIB_EXPORT DL_HatchBoundary {
+public:
+    /** Edge with the ranges of its points in the boundary arrays. */
+    struct Edge {
+        /*! Type and scalar values of the edge. */
+        DL_HatchEdgeData data;
+        /*! Polyline edges have bulges (group code 42). */
+        bool hasBulges;
+        size_t firstVertex;
+        size_t numVertices;
+        size_t firstControlPoint;
+        size_t numControlPoints;
+        size_t firstFitPoint;
+        size_t numFitPoints;
+        size_t firstKnot;
+        size_t numKnots;
+        size_t firstWeight;
+        size_t numWeights;
+    };
+
+    DL_HatchBoundary() {
+        clear();
+    }
+
+    /**
+     * Removes all loops, edges and points.
+     */
+    void clear() {
+        loops.clear();
+        loopFlags.clear();
+        edges.clear();
+        vertices.clear();
+        controlPoints.clear();
+        fitPoints.clear();
+        knots.clear();
+        weights.clear();
+        openHasBulges = false;
+        openEdge();
+    }
+
+    /**
+     * Starts a new loop with the given boundary path type flags
+     * (group code 92).
+     */
+    void addLoop(int flags) {
+        loops.push_back(edges.size());
+        loopFlags.push_back(flags);
+    }
+
+    /**
+     * Closes the open edge with the given values. The edge is only
+     * added if \p data is defined and there is a loop, otherwise its
+     * points are dropped.
+     */
+    void endEdge(const DL_HatchEdgeData& data) {
+        if (data.defined && !loops.empty()) {
+            Edge e;
+            e.data = data;
+            e.hasBulges = openHasBulges;
+            e.firstVertex = openVertex;
+            e.numVertices = vertices.size() - openVertex;
+            e.firstControlPoint = openControlPoint;
+            e.numControlPoints = controlPoints.size() - openControlPoint;
+            e.firstFitPoint = openFitPoint;
+            e.numFitPoints = fitPoints.size() - openFitPoint;
+            e.firstKnot = openKnot;
+            e.numKnots = knots.size() - openKnot;
+            e.firstWeight = openWeight;
+            e.numWeights = weights.size() - openWeight;
+            edges.push_back(e);
+        } else {
+            dropEdge();
+        }
+        openEdge();
+    }
+
+    /**
+     * Drops the points of the open edge.
+     */
+    void dropEdge() {
+        vertices.resize(openVertex);
+        controlPoints.resize(openControlPoint);
+        fitPoints.resize(openFitPoint);
+        knots.resize(openKnot);
+        weights.resize(openWeight);
+        openHasBulges = false;
+    }
+
+    /** Appends a polyline vertex to the open edge. */
+    void addVertex(double x) {
+        vertices.push_back(DL_HatchVertexData(x));
+    }
+
+    /** @return Last vertex of the open edge or NULL. */
+    DL_HatchVertexData* lastVertex() {
+        return vertices.size()>openVertex ? &vertices.back() : NULL;
+    }
+
+    /** Sets the bulge of the last vertex of the open edge. */
+    void setBulge(double bulge) {
+        if (vertices.size()>openVertex) {
+            vertices.back().bulge = bulge;
+            openHasBulges = true;
+        }
+    }
+
+    void addControlPoint(double x) {
+        controlPoints.push_back(DL_HatchVertexData(x));
+    }
+
+    DL_HatchVertexData* lastControlPoint() {
+        return controlPoints.size()>openControlPoint ? &controlPoints.back() : NULL;
+    }
+
+    void addFitPoint(double x) {
+        fitPoints.push_back(DL_HatchVertexData(x));
+    }
+
+    DL_HatchVertexData* lastFitPoint() {
+        return fitPoints.size()>openFitPoint ? &fitPoints.back() : NULL;
+    }
+
+    void addKnot(double k) {
+        knots.push_back(k);
+    }
+
+    void addWeight(double w) {
+        weights.push_back(w);
+    }
+
+    /** @return Number of control points, fit points, ... of the open edge. */
+    size_t getOpenControlPoints() const {
+        return controlPoints.size() - openControlPoint;
+    }
+
+    size_t getOpenFitPoints() const {
+        return fitPoints.size() - openFitPoint;
+    }
+
+    size_t getOpenKnots() const {
+        return knots.size() - openKnot;
+    }
+
+    size_t getOpenWeights() const {
+        return weights.size() - openWeight;
+    }
+
+    size_t getLoopCount() const {
+        return loops.size();
+    }
+
+    /** @return Boundary path type flags of the given loop. */
+    int getLoopFlags(size_t loop) const {
+        return loopFlags[loop];
+    }
+
+    /** @return Edges of the given loop. */
+    DL_Span<Edge> getEdges(size_t loop) const {
+        size_t first = loops[loop];
+        size_t last = loop+1<loops.size() ? loops[loop+1] : edges.size();
+        return DL_Span<Edge>(edges.empty() ? NULL : &edges[0] + first,
+                             last - first);
+    }
+
+    DL_Span<DL_HatchVertexData> getVertices(const Edge& edge) const {
+        return span(vertices, edge.firstVertex, edge.numVertices);
+    }
+
+    DL_Span<DL_HatchVertexData> getControlPoints(const Edge& edge) const {
+        return span(controlPoints, edge.firstControlPoint, edge.numControlPoints);
+    }
+
+    DL_Span<DL_HatchVertexData> getFitPoints(const Edge& edge) const {
+        return span(fitPoints, edge.firstFitPoint, edge.numFitPoints);
+    }
+
+    DL_Span<double> getKnots(const Edge& edge) const {
+        return span(knots, edge.firstKnot, edge.numKnots);
+    }
+
+    DL_Span<double> getWeights(const Edge& edge) const {
+        return span(weights, edge.firstWeight, edge.numWeights);
+    }
+
+    /**
+     * @return The edge in the form of the addHatchEdge() callback, with
+     *      its points copied into the vectors of DL_HatchEdgeData.
+     */
+    DL_HatchEdgeData getEdgeData(const Edge& edge) const {
+        DL_HatchEdgeData d = edge.data;
+
+        DL_Span<DL_HatchVertexData> v = getVertices(edge);
+        for (size_t i=0; i<v.size; ++i) {
+            std::vector<double> p;
+            p.push_back(v[i].x);
+            p.push_back(v[i].y);
+            if (edge.hasBulges) {
+                p.push_back(v[i].bulge);
+            }
+            d.vertices.push_back(p);
+        }
+
+        DL_Span<DL_HatchVertexData> c = getControlPoints(edge);
+        for (size_t i=0; i<c.size; ++i) {
+            std::vector<double> p;
+            p.push_back(c[i].x);
+            p.push_back(c[i].y);
+            d.controlPoints.push_back(p);
+        }
+
+        DL_Span<DL_HatchVertexData> f = getFitPoints(edge);
+        for (size_t i=0; i<f.size; ++i) {
+            std::vector<double> p;
+            p.push_back(f[i].x);
+            p.push_back(f[i].y);
+            d.fitPoints.push_back(p);
+        }
+
+        DL_Span<double> k = getKnots(edge);
+        d.knots.assign(k.begin(), k.end());
+        DL_Span<double> w = getWeights(edge);
+        d.weights.assign(w.begin(), w.end());
+        return d;
+    }
+
+private:
+    template <class T>
+    static DL_Span<T> span(const std::vector<T>& v, size_t first, size_t count) {
+        return DL_Span<T>(count>0 ? &v[first] : NULL, count);
+    }
+
+    void openEdge() {
+        openVertex = vertices.size();
+        openControlPoint = controlPoints.size();
+        openFitPoint = fitPoints.size();
+        openKnot = knots.size();
+        openWeight = weights.size();
+        openHasBulges = false;
+    }
+
+    // First edge of every loop:
+    std::vector<size_t> loops;
+    std::vector<int> loopFlags;
+    std::vector<Edge> edges;
+    std::vector<DL_HatchVertexData> vertices;
+    std::vector<DL_HatchVertexData> controlPoints;
+    std::vector<DL_HatchVertexData> fitPoints;
+    std::vector<double> knots;
+    std::vector<double> weights;
+
+    // Start of the points of the open edge:
+    size_t openVertex;
+    size_t openControlPoint;
+    size_t openFitPoint;
+    size_t openKnot;
+    size_t openWeight;
+    bool openHasBulges;
+};
+
+#endif
+
+// EOF
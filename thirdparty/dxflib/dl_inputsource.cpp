@@ -0,0 +1,303 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#include "dl_inputsource.h"
+
+#include <string.h>
+
+#ifdef DL_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DL_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Largest block handed to zlib at once, its counters are 32 bit:
+#define DL_INPUTSOURCE_MAXBLOCK 0x40000000
+
+
+/**
+ * Default constructor.
+ */
+DL_DecompressingSource::DL_DecompressingSource() :
+    format(NoCompression),
+    input(NULL),
+    inputSize(0),
+    inputPosition(0),
+    decoder(NULL),
+    frameDone(false),
+    finished(true),
+    error(false) {
+}
+
+
+
+/**
+ * Destructor. Frees the decoder.
+ */
+DL_DecompressingSource::~DL_DecompressingSource() {
+    close();
+}
+
+
+
+/**
+ * @return Compression format of the data starting with \p data, found
+ *      by its magic bytes.
+ */
+DL_DecompressingSource::Format DL_DecompressingSource::getFormat(const char* data, size_t size) {
+    if (data==NULL) {
+        return NoCompression;
+    }
+    const unsigned char* d = (const unsigned char*)data;
+    if (size>=2 && d[0]==0x1f && d[1]==0x8b) {
+        return Gzip;
+    }
+    if (size>=4 && d[0]==0x28 && d[1]==0xb5 && d[2]==0x2f && d[3]==0xfd) {
+        return Zstd;
+    }
+    return NoCompression;
+}
+
+
+
+/**
+ * @retval true if the library for \p format has been compiled in.
+ */
+bool DL_DecompressingSource::isSupported(Format format) {
+    switch (format) {
+#ifdef DL_HAVE_ZLIB
+    case Gzip:
+        return true;
+#endif
+#ifdef DL_HAVE_ZSTD
+    case Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+
+
+/**
+ * Starts to decompress the given block of memory which has to stay
+ * valid while the source is read.
+ *
+ * @retval true if the format of \p data is supported and the decoder
+ *      could be set up.
+ */
+bool DL_DecompressingSource::open(const char* data, size_t size) {
+    close();
+
+    Format f = getFormat(data, size);
+    if (!isSupported(f)) {
+        return false;
+    }
+
+#ifdef DL_HAVE_ZLIB
+    if (f==Gzip) {
+        z_stream* z = new z_stream();
+        // window bits + 16: gzip header and trailer
+        if (inflateInit2(z, 15 + 16)!=Z_OK) {
+            delete z;
+            return false;
+        }
+        decoder = z;
+    }
+#endif
+#ifdef DL_HAVE_ZSTD
+    if (f==Zstd) {
+        ZSTD_DStream* zs = ZSTD_createDStream();
+        if (zs==NULL || ZSTD_isError(ZSTD_initDStream(zs))) {
+            ZSTD_freeDStream(zs);
+            return false;
+        }
+        decoder = zs;
+    }
+#endif
+
+    format = f;
+    input = data;
+    inputSize = size;
+    inputPosition = 0;
+    frameDone = false;
+    finished = false;
+    error = false;
+    return true;
+}
+
+
+
+/**
+ * Frees the decoder. The source can be opened again.
+ */
+void DL_DecompressingSource::close() {
+#ifdef DL_HAVE_ZLIB
+    if (format==Gzip) {
+        z_stream* z = (z_stream*)decoder;
+        inflateEnd(z);
+        delete z;
+    }
+#endif
+#ifdef DL_HAVE_ZSTD
+    if (format==Zstd) {
+        ZSTD_freeDStream((ZSTD_DStream*)decoder);
+    }
+#endif
+
+    format = NoCompression;
+    input = NULL;
+    inputSize = 0;
+    inputPosition = 0;
+    decoder = NULL;
+    frameDone = false;
+    finished = true;
+    error = false;
+}
+
+
+
+/**
+ * Decompresses the next \p size bytes into \p buffer.
+ *
+ * @return Number of bytes decompressed. Less than \p size at the end
+ *      of the compressed data or if it is corrupt or cut off, see
+ *      hasError().
+ */
+size_t DL_DecompressingSource::read(char* buffer, size_t size) {
+    size_t count = 0;
+    while (count<size && !finished) {
+        size_t block = size - count;
+        if (block>DL_INPUTSOURCE_MAXBLOCK) {
+            block = DL_INPUTSOURCE_MAXBLOCK;
+        }
+
+        size_t n = format==Gzip ? readGzip(buffer + count, block) :
+                                  readZstd(buffer + count, block);
+        count += n;
+        if (n<block) {
+            break;
+        }
+    }
+    return count;
+}
+
+
+
+/**
+ * Inflates gzip members into \p buffer until it is full.
+ */
+size_t DL_DecompressingSource::readGzip(char* buffer, size_t size) {
+#ifdef DL_HAVE_ZLIB
+    z_stream* z = (z_stream*)decoder;
+    z->next_out = (Bytef*)buffer;
+    z->avail_out = (uInt)size;
+
+    while (z->avail_out>0) {
+        if (z->avail_in==0) {
+            size_t block = inputSize - inputPosition;
+            if (block==0) {
+                // cut off in the middle of a member:
+                error = true;
+                finished = true;
+                break;
+            }
+            if (block>DL_INPUTSOURCE_MAXBLOCK) {
+                block = DL_INPUTSOURCE_MAXBLOCK;
+            }
+            z->next_in = (Bytef*)(input + inputPosition);
+            z->avail_in = (uInt)block;
+            inputPosition += block;
+        }
+
+        int ret = inflate(z, Z_NO_FLUSH);
+        if (ret==Z_STREAM_END) {
+            // another member may follow, anything else (e.g. padding)
+            // ends the file:
+            const char* next = (const char*)z->next_in;
+            if (getFormat(next, input + inputSize - next)!=Gzip) {
+                finished = true;
+                break;
+            }
+            inflateReset(z);
+        }
+        else if (ret!=Z_OK) {
+            error = true;
+            finished = true;
+            break;
+        }
+    }
+
+    return size - z->avail_out;
+#else
+    (void)buffer;
+    (void)size;
+    error = true;
+    finished = true;
+    return 0;
+#endif
+}
+
+
+
+/**
+ * Decompresses zstd frames into \p buffer until it is full.
+ */
+size_t DL_DecompressingSource::readZstd(char* buffer, size_t size) {
+#ifdef DL_HAVE_ZSTD
+    ZSTD_DStream* zs = (ZSTD_DStream*)decoder;
+    ZSTD_outBuffer out = { buffer, size, 0 };
+
+    while (out.pos<out.size) {
+        if (inputPosition==inputSize && frameDone) {
+            finished = true;
+            break;
+        }
+
+        ZSTD_inBuffer in = { input, inputSize, inputPosition };
+        size_t outStart = out.pos;
+        size_t ret = ZSTD_decompressStream(zs, &out, &in);
+        bool progress = in.pos!=inputPosition || out.pos!=outStart;
+        inputPosition = in.pos;
+        if (ZSTD_isError(ret) || !progress) {
+            // corrupt, or cut off in the middle of a frame:
+            error = true;
+            finished = true;
+            break;
+        }
+        frameDone = (ret==0);
+    }
+
+    return out.pos;
+#else
+    (void)buffer;
+    (void)size;
+    error = true;
+    finished = true;
+    return 0;
+#endif
+}
+
+// EOF
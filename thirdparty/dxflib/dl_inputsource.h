@@ -0,0 +1,121 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_INPUTSOURCE_H
+#define DL_INPUTSOURCE_H
+
+#include "dl_global.h"
+
+#include <stddef.h>
+
+/**
+ * Source of the bytes of a DXF file which is not at hand as a whole.
+ *
+ * DL_LineReader pulls the bytes block by block into its own read
+ * buffer, so a source never has to hold more than the block that is
+ * asked for. Derive from this class to read DXF from other places
+ * and pass the source to DL_Dxf::in(DL_InputSource&, ...).
+ */
+class DXFLIB_EXPORT DL_InputSource {
+public:
+    virtual ~DL_InputSource() {}
+
+    /**
+     * Copies the next bytes of the source to \p buffer.
+     *
+     * @return Number of bytes copied. Less than \p size only at the
+     *      end of the source or after an error.
+     */
+    virtual size_t read(char* buffer, size_t size) = 0;
+
+    /** @return true if the source could not be read completely. */
+    virtual bool hasError() const {
+        return false;
+    }
+};
+
+
+
+/**
+ * Decompresses a gzip or zstd compressed DXF file while it is read.
+ *
+ * The compressed data is read in place from a block of memory (usually
+ * a DL_MappedFile). The decompressed data is written straight into the
+ * buffer passed to read(), so apart from the decoder state (32 KB for
+ * gzip, the frame window for zstd) no memory is needed however large
+ * the file is.
+ *
+ * gzip support needs zlib (DL_HAVE_ZLIB), zstd support needs libzstd
+ * (DL_HAVE_ZSTD). Several gzip members or zstd frames in a row are
+ * read as one file.
+ */
+class DXFLIB_EXPORT DL_DecompressingSource : public DL_InputSource {
+public:
+    enum Format {
+        NoCompression,
+        Gzip,
+        Zstd
+    };
+
+    DL_DecompressingSource();
+    virtual ~DL_DecompressingSource();
+
+    static Format getFormat(const char* data, size_t size);
+    static bool isSupported(Format format);
+
+    bool open(const char* data, size_t size);
+    void close();
+
+    Format getFormat() const {
+        return format;
+    }
+
+    virtual size_t read(char* buffer, size_t size);
+
+    virtual bool hasError() const {
+        return error;
+    }
+
+private:
+    DL_DecompressingSource(const DL_DecompressingSource&);
+    DL_DecompressingSource& operator=(const DL_DecompressingSource&);
+
+    size_t readGzip(char* buffer, size_t size);
+    size_t readZstd(char* buffer, size_t size);
+
+    Format format;
+    // Compressed input and the number of bytes passed to the decoder:
+    const char* input;
+    size_t inputSize;
+    size_t inputPosition;
+    // z_stream or ZSTD_DStream, depending on the format:
+    void* decoder;
+    // Last zstd frame is complete and flushed:
+    bool frameDone;
+    bool finished;
+    bool error;
+};
+
+#endif
+
+// EOF
@@ -0,0 +1,403 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#include "dl_linereader.h"
+
+#include <string.h>
+
+// Size of the read buffer for file and stream sources:
+#define DL_LINEREADER_BUFFERSIZE 65536
+
+
+/**
+ * Default constructor.
+ */
+DL_LineReader::DL_LineReader() :
+    sourceType(NoSource),
+    sourcePointer(NULL),
+    file(NULL),
+    stream(NULL),
+    input(NULL),
+    sourceEof(true),
+    memoryData(NULL),
+    sourceBytes(0),
+    cursor(NULL),
+    dataEnd(NULL) {
+}
+
+
+
+/**
+ * Reads lines from the given file. The file is read in large blocks,
+ * so its position is ahead of the last line returned.
+ */
+void DL_LineReader::setSource(FILE* fp) {
+    clear();
+    sourceType = FileSource;
+    sourcePointer = fp;
+    file = fp;
+    sourceEof = false;
+}
+
+
+
+/**
+ * Reads lines from the given stream.
+ */
+void DL_LineReader::setSource(std::istream& stream) {
+    clear();
+    sourceType = StreamSource;
+    sourcePointer = &stream;
+    this->stream = &stream;
+    sourceEof = false;
+}
+
+
+
+/**
+ * Reads lines from the given input source, e.g. a file which is
+ * decompressed while it is read.
+ */
+void DL_LineReader::setSource(DL_InputSource& source) {
+    clear();
+    sourceType = InputSource;
+    sourcePointer = &source;
+    input = &source;
+    sourceEof = false;
+}
+
+
+
+/**
+ * Reads lines in place from the given block of memory which has to
+ * stay valid while lines are read.
+ */
+void DL_LineReader::setSource(const char* data, size_t size) {
+    clear();
+    sourceType = MemorySource;
+    sourcePointer = data;
+    memoryData = data;
+    sourceBytes = size;
+    cursor = data;
+    dataEnd = data + size;
+}
+
+
+
+/**
+ * Detaches the reader from its source. The buffer keeps its capacity.
+ */
+void DL_LineReader::clear() {
+    sourceType = NoSource;
+    sourcePointer = NULL;
+    file = NULL;
+    stream = NULL;
+    input = NULL;
+    sourceEof = true;
+    memoryData = NULL;
+    sourceBytes = 0;
+    cursor = NULL;
+    dataEnd = NULL;
+}
+
+
+
+/**
+ * @brief Returns the next line with leading whitespace and trailing
+ * newline stripped.
+ *
+ * @param line Output\n
+ *      Start of the stripped line.
+ * @param length Output\n
+ *      Length of the stripped line.
+ * @param stripSpace Strip spaces and tabs at start and end of the line
+ *      in addition to CR/LF.
+ *
+ * @retval true if line could be read
+ * @retval false if the end of the source has been reached
+ */
+bool DL_LineReader::getStrippedLine(const char*& line, size_t& length, bool stripSpace) {
+    const char* first;
+    const char* last;
+
+    while (true) {
+        if (cursor<dataEnd) {
+            const char* lf = (const char*)memchr(cursor, '\n', dataEnd-cursor);
+            if (lf!=NULL) {
+                first = cursor;
+                last = lf;
+                cursor = lf + 1;
+                break;
+            }
+        }
+
+        if (sourceEof || !fill()) {
+            // last line without line feed:
+            if (cursor<dataEnd) {
+                first = cursor;
+                last = dataEnd;
+                cursor = dataEnd;
+                break;
+            }
+            line = cursor;
+            length = 0;
+            return false;
+        }
+    }
+
+    // Strip trailing CR/LF (and spaces):
+    while (last>first &&
+           (last[-1]=='\r' ||
+            (stripSpace && (last[-1]==' ' || last[-1]=='\t')))) {
+        --last;
+    }
+
+    // Strip leading whitespace:
+    if (stripSpace) {
+        while (first<last && (*first==' ' || *first=='\t')) {
+            ++first;
+        }
+    }
+
+    line = first;
+    length = last - first;
+    return true;
+}
+
+
+
+/**
+ * @retval true if all lines of the source have been read.
+ */
+bool DL_LineReader::atEnd() {
+    if (cursor<dataEnd) {
+        return false;
+    }
+    return sourceEof || !fill();
+}
+
+
+
+/**
+ * Returns the unread data in the buffer without consuming it. For
+ * sources other than memory the buffer is filled first if it is
+ * empty, so at least the first block of the source is returned
+ * (e.g. to check the file format).
+ */
+void DL_LineReader::peek(const char*& data, size_t& size) {
+    if (cursor>=dataEnd && !sourceEof) {
+        fill();
+    }
+    data = cursor;
+    size = dataEnd - cursor;
+}
+
+
+
+/**
+ * Reads all remaining data of the source into \p contents, e.g. to
+ * decode binary DXF which can only be read from memory.
+ */
+void DL_LineReader::readAll(std::string& contents) {
+    contents.clear();
+    while (true) {
+        if (cursor<dataEnd) {
+            contents.append(cursor, dataEnd - cursor);
+            cursor = dataEnd;
+        }
+        if (sourceEof || !fill()) {
+            break;
+        }
+    }
+}
+
+
+
+/**
+ * Moves the cursor to the given byte offset from the start of the
+ * source. Only supported for memory sources.
+ *
+ * @retval true if the position could be set.
+ */
+bool DL_LineReader::seek(size_t position) {
+    if (sourceType!=MemorySource || position>sourceBytes) {
+        return false;
+    }
+    cursor = memoryData + position;
+    return true;
+}
+
+
+
+/**
+ * Moves the cursor to the next group with code 0 and the given value
+ * (e.g. "ENDSEC") without splitting the lines in between. The raw
+ * bytes are searched for the value, only for a hit the line in front
+ * of it is checked for the group code.
+ *
+ * @return Number of bytes skipped. The next line read is the group
+ *      code line of the group found or, if there is none, the source
+ *      is at its end.
+ */
+size_t DL_LineReader::skipToGroup(const char* value) {
+    size_t valueLength = strlen(value);
+    size_t start = position();
+
+    while (true) {
+        const char* group = findGroup(value, valueLength);
+        if (group!=NULL) {
+            cursor = group;
+            return position() - start;
+        }
+
+        if (sourceEof) {
+            cursor = dataEnd;
+            return position() - start;
+        }
+
+        // A group may be cut off at the end of the buffer, keep its
+        // code line and the start of its value line:
+        const char* keep = dataEnd;
+        int lines = 0;
+        while (keep>cursor && lines<2) {
+            --keep;
+            if (*keep=='\n') {
+                lines++;
+            }
+        }
+        if (lines==2) {
+            ++keep;
+        }
+        cursor = keep;
+        fill();
+    }
+}
+
+
+
+/**
+ * @return Start of the group code line of the first complete group
+ *      with code 0 and the given value behind the cursor or NULL.
+ */
+const char* DL_LineReader::findGroup(const char* value, size_t valueLength) const {
+    const char* p = cursor;
+    while (p<dataEnd) {
+        const char* hit = (const char*)memchr(p, value[0], dataEnd-p);
+        if (hit==NULL) {
+            return NULL;
+        }
+        p = hit + 1;
+
+        // The value must fill a whole line, the line before it must
+        // be part of the data:
+        if (hit==cursor || hit[-1]!='\n') {
+            continue;
+        }
+        const char* end = hit + valueLength;
+        if (end>dataEnd || memcmp(hit, value, valueLength)!=0) {
+            continue;
+        }
+        while (end<dataEnd && *end=='\r') {
+            ++end;
+        }
+        if (end<dataEnd ? *end!='\n' : !sourceEof) {
+            continue;
+        }
+
+        // The line before must be the group code 0:
+        const char* codeEnd = hit - 1;
+        const char* codeStart = codeEnd;
+        while (codeStart>cursor && codeStart[-1]!='\n') {
+            --codeStart;
+        }
+        const char* c = codeStart;
+        while (c<codeEnd && (*c==' ' || *c=='\t')) {
+            ++c;
+        }
+        if (c<codeEnd && *c=='0') {
+            ++c;
+            while (c<codeEnd && (*c==' ' || *c=='\t' || *c=='\r')) {
+                ++c;
+            }
+            if (c==codeEnd) {
+                return codeStart;
+            }
+        }
+    }
+    return NULL;
+}
+
+
+
+/**
+ * Moves the unread data to the front of the buffer and appends the
+ * next block from the file, stream or input source. The buffer only grows if it
+ * is completely filled by a single line.
+ *
+ * @retval true if more data could be read.
+ */
+bool DL_LineReader::fill() {
+    if (sourceType!=FileSource && sourceType!=StreamSource &&
+        sourceType!=InputSource) {
+        sourceEof = true;
+        return false;
+    }
+
+    if (buffer.empty()) {
+        buffer.resize(DL_LINEREADER_BUFFERSIZE);
+    }
+
+    size_t remaining = 0;
+    if (cursor!=NULL) {
+        remaining = dataEnd - cursor;
+        if (remaining>0 && cursor!=&buffer[0]) {
+            memmove(&buffer[0], cursor, remaining);
+        }
+    }
+    if (remaining==buffer.size()) {
+        buffer.resize(buffer.size()*2);
+    }
+
+    size_t requested = buffer.size() - remaining;
+    size_t count = 0;
+    if (sourceType==FileSource) {
+        count = fread(&buffer[remaining], 1, requested, file);
+    } else if (sourceType==InputSource) {
+        count = input->read(&buffer[remaining], requested);
+    } else {
+        stream->read(&buffer[remaining], requested);
+        count = (size_t)stream->gcount();
+    }
+
+    // a short read means end of file (or a read error):
+    if (count<requested) {
+        sourceEof = true;
+    }
+
+    sourceBytes += count;
+    cursor = &buffer[0];
+    dataEnd = cursor + remaining + count;
+    return count>0;
+}
+
+// EOF
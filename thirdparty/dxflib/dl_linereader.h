@@ -0,0 +1,110 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_LINEREADER_H
+#define DL_LINEREADER_H
+
+#include "dl_global.h"
+#include "dl_inputsource.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * Buffered cursor over the lines of a DXF file.
+ *
+ * Lines are returned as slices (pointer and length) into an internal
+ * buffer which is reused from line to line, or directly into the
+ * memory block given to setSource(). Files, streams and other input
+ * sources (e.g. a DL_DecompressingSource) are read through a single
+ * read buffer, so memory stays bounded by the longest line. Leading and trailing white space
+ * is stripped by moving the slice boundaries, no line is copied and
+ * no memory is allocated per line.
+ *
+ * A slice stays valid until the next call of getStrippedLine().
+ */
+class DXFLIB_EXPORT DL_LineReader {
+public:
+    DL_LineReader();
+
+    void setSource(FILE* fp);
+    void setSource(std::istream& stream);
+    void setSource(const char* data, size_t size);
+    void setSource(DL_InputSource& source);
+    void clear();
+
+    /** @return true if \p source is the file or stream currently read. */
+    bool hasSource(const void* source) const {
+        return sourceType!=NoSource && source==sourcePointer;
+    }
+
+    bool getStrippedLine(const char*& line, size_t& length, bool stripSpace = true);
+    bool atEnd();
+    void peek(const char*& data, size_t& size);
+    void readAll(std::string& contents);
+
+    /** @return Number of bytes consumed from the source so far. */
+    size_t position() const {
+        return sourceBytes - (dataEnd - cursor);
+    }
+
+    bool seek(size_t position);
+    size_t skipToGroup(const char* value);
+
+private:
+    bool fill();
+    const char* findGroup(const char* value, size_t valueLength) const;
+
+    enum SourceType {
+        NoSource,
+        FileSource,
+        StreamSource,
+        InputSource,
+        MemorySource
+    };
+
+    SourceType sourceType;
+    const void* sourcePointer;
+    FILE* file;
+    std::istream* stream;
+    DL_InputSource* input;
+    bool sourceEof;
+    // Start of the data of a memory source:
+    const char* memoryData;
+    // Number of bytes taken from the source so far:
+    size_t sourceBytes;
+
+    // Read buffer for file, stream and input sources. Grows only for lines
+    // longer than the buffer:
+    std::vector<char> buffer;
+    // Current position and end of the unread data:
+    const char* cursor;
+    const char* dataEnd;
+};
+
+#endif
+
+// EOF
@@ -0,0 +1,161 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#include "dl_mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * Default constructor.
+ */
+DL_MappedFile::DL_MappedFile() :
+    mappedData(NULL),
+    mappedSize(0),
+    opened(false) {
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+#else
+    fileDescriptor = -1;
+#endif
+}
+
+
+
+/**
+ * Destructor. Unmaps the file if it is still mapped.
+ */
+DL_MappedFile::~DL_MappedFile() {
+    close();
+}
+
+
+
+/**
+ * Maps the given file read-only into memory.
+ *
+ * @param file Path and name of the file to map.
+ *
+ * @retval true If \p file could be opened and mapped. An empty file
+ *      is opened successfully with no data.
+ * @retval false Otherwise.
+ */
+bool DL_MappedFile::open(const std::string& file) {
+    close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle==INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    mappedSize = (size_t)fileSize.QuadPart;
+
+    if (mappedSize>0) {
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mappingHandle==NULL) {
+            close();
+            return false;
+        }
+        mappedData = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        if (mappedData==NULL) {
+            close();
+            return false;
+        }
+    }
+#else
+    fileDescriptor = ::open(file.c_str(), O_RDONLY);
+    if (fileDescriptor<0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat)!=0) {
+        close();
+        return false;
+    }
+    mappedSize = (size_t)fileStat.st_size;
+
+    if (mappedSize>0) {
+        void* p = mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (p==MAP_FAILED) {
+            close();
+            return false;
+        }
+        // the file is read front to back exactly once:
+        madvise(p, mappedSize, MADV_SEQUENTIAL);
+        mappedData = (const char*)p;
+    }
+#endif
+
+    opened = true;
+    return true;
+}
+
+
+
+/**
+ * Unmaps the file and closes all handles.
+ */
+void DL_MappedFile::close() {
+#ifdef _WIN32
+    if (mappedData!=NULL) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle!=NULL) {
+        CloseHandle(mappingHandle);
+        mappingHandle = NULL;
+    }
+    if (fileHandle!=INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mappedData!=NULL) {
+        munmap((void*)mappedData, mappedSize);
+    }
+    if (fileDescriptor>=0) {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+    mappedData = NULL;
+    mappedSize = 0;
+    opened = false;
+}
+
+// EOF
@@ -0,0 +1,78 @@
+﻿/****************************************************************************
+**
+** This file is part of the dxflib project.
+**
+** This file is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** Licensees holding valid dxflib Professional Edition licenses may use 
+** this file in accordance with the dxflib Commercial License
+** Agreement provided with the Software.
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+** See http://www.ribbonsoft.com for further details.
+**
+** Contact info@ribbonsoft.com if any conditions of this licensing are
+** not clear to you.
+**
+**********************************************************************/
+
+#ifndef DL_MAPPEDFILE_H
+#define DL_MAPPEDFILE_H
+
+#include "dl_global.h"
+
+#include <stddef.h>
+#include <string>
+
+/**
+ * Read-only memory mapping of a file.
+ *
+ * The mapped pages are handed to DL_Dxf which tokenizes the group
+ * code / value lines directly from them. No copy of the file contents
+ * is made, so peak memory stays close to the size of the file.
+ */
+class DXFLIB_EXPORT DL_MappedFile {
+public:
+    DL_MappedFile();
+    ~DL_MappedFile();
+
+    bool open(const std::string& file);
+    void close();
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    /** @return Pointer to the first byte of the mapped file. */
+    const char* data() const {
+        return mappedData;
+    }
+
+    /** @return Size of the mapped file in bytes. */
+    size_t size() const {
+        return mappedSize;
+    }
+
+private:
+    DL_MappedFile(const DL_MappedFile&);
+    DL_MappedFile& operator=(const DL_MappedFile&);
+
+    const char* mappedData;
+    size_t mappedSize;
+    bool opened;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
+
+#endif
+
+// EOF
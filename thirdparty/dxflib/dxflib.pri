@@ -0,0 +1,42 @@
+INCLUDEPATH += $$PWD
+
+# Compressed DXF input (.dxf.gz, .dxf.zst), see DL_DecompressingSource:
+packagesExist(zlib) {
+    DEFINES += DL_HAVE_ZLIB
+    CONFIG += link_pkgconfig
+    PKGCONFIG += zlib
+}
+packagesExist(libzstd) {
+    DEFINES += DL_HAVE_ZSTD
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+}
+
+SOURCES += \
+    $$PWD/dl_binaryreader.cpp \
+    $$PWD/dl_dxf.cpp \
+    $$PWD/dl_entitybuffer.cpp \
+    $$PWD/dl_inputsource.cpp \
+    $$PWD/dl_linereader.cpp \
+    $$PWD/dl_mappedfile.cpp \
+    $$PWD/dl_writer_ascii.cpp
+
+HEADERS += \
+    $$PWD/dl_attributes.h \
+    $$PWD/dl_binaryreader.h \
+    $$PWD/dl_codes.h \
+    $$PWD/dl_creationadapter.h \
+    $$PWD/dl_creationinterface.h \
+    $$PWD/dl_dxf.h \
+    $$PWD/dl_entities.h \
+    $$PWD/dl_entitybuffer.h \
+    $$PWD/dl_exception.h \
+    $$PWD/dl_extrusion.h \
+    $$PWD/dl_groupvalues.h \
+    $$PWD/dl_hatchboundary.h \
+    $$PWD/dl_inputsource.h \
+    $$PWD/dl_linereader.h \
+    $$PWD/dl_mappedfile.h \
+    $$PWD/dl_global.h \
+    $$PWD/dl_writer.h \
+    $$PWD/dl_writer_ascii.h